@@ -0,0 +1,143 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_ASYNCWRITER_H_
+#define ODF_ASYNCWRITER_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <odf/image.h>
+#include <odf/boundedqueue.h>
+
+namespace ODF
+{
+    /**
+     * Encode and save images in background threads.
+     *
+     * The writer keeps a reference to the image matrix, so the image can be
+     * closed right after AsyncWriter::write() returns. Pixels are not copied
+     * unless requested, so the caller must not modify the matrix data until
+     * the image is written (e.g. a reused capture buffer must be copied).
+     */
+    class AsyncWriter
+    {
+    public:
+        /**
+         * Called from a writer thread when an image was saved or failed to
+         * be saved.
+         *
+         * @param[in] filename Name of the written file.
+         * @param[in] success True if the image was saved.
+         * @param[in] error Error message if 'success' is false.
+         */
+        typedef std::function<void (const std::string &filename,
+                                    bool success,
+                                    const std::string &error)> Callback;
+
+        /**
+         * Create a new writer.
+         *
+         * @param[in] num_threads Number of encoder threads (0 means one
+         *                        thread per available CPU core).
+         * @param[in] capacity Maximum number of queued images. Further
+         *                     calls of AsyncWriter::write() block.
+         * @param[in] params Encoder parameters passed to cv::imwrite, e.g.
+         *                   CV_IMWRITE_PNG_COMPRESSION and its value.
+         * @param[in] callback Completion callback, may be empty.
+         */
+        AsyncWriter(unsigned int num_threads = 1,
+                    size_t capacity = 16,
+                    const std::vector<int> &params = std::vector<int>(),
+                    const Callback &callback = Callback());
+
+        /**
+         * Write all queued images and stop the threads.
+         */
+        ~AsyncWriter();
+
+        /**
+         * Queue 'image' to be saved into 'filename'. The file name may use
+         * the format accepted by Image::save().
+         *
+         * @param[in] image Image to be saved.
+         * @param[in] filename Output file name.
+         * @param[in] copy Copy the pixels instead of referencing them.
+         *
+         * @throws logic_error if the image is not opened.
+         */
+        void write(const Image &image, const std::string &filename,
+                   bool copy = false);
+
+        /**
+         * Queue 'matrix' to be saved into 'filename'.
+         */
+        void write(const cv::Mat &matrix, const std::string &filename,
+                   bool copy = false);
+
+        /**
+         * Block until all queued images are written.
+         */
+        void flush();
+
+        /**
+         * @return Number of images that failed to be saved.
+         */
+        unsigned long failures() const;
+
+        /**
+         * @return Number of images that were saved.
+         */
+        unsigned long written() const;
+
+    private:
+        struct Job
+        {
+            std::string filename;
+            cv::Mat matrix;
+        };
+
+        BoundedQueue<Job*> queue;
+        std::vector<std::thread> threads;
+        std::vector<int> params;
+        Callback callback;
+
+        mutable std::mutex mutex;
+        std::condition_variable done;
+        unsigned long pending;
+        unsigned long num_failures;
+        unsigned long num_written;
+
+        AsyncWriter(const AsyncWriter &);
+        AsyncWriter & operator=(const AsyncWriter &);
+
+        void worker();
+        void finish(const Job *job, bool success, const std::string &error);
+    };
+}
+
+#endif /* ODF_ASYNCWRITER_H_ */
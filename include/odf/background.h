@@ -0,0 +1,222 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_BACKGROUND_H_
+#define ODF_BACKGROUND_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <stdint.h>
+
+namespace ODF
+{
+    /**
+     * Background subtractor that models the background on a downscaled
+     * frame.
+     *
+     * The frame is downscaled by 'scale', passed to the wrapped subtractor
+     * and the resulting mask is cleaned by morphological opening and
+     * upsampled back to the frame size. Background modelling cost drops by
+     * roughly scale^2.
+     *
+     * Since the mask is already cleaned, mark the subtractor by
+     * ForegroundBuffers::setCleaned() so Image::getForegroundMask() does
+     * not apply its own morphology on it.
+     */
+    class ScaledBackgroundSubtractor : public cv::BackgroundSubtractor
+    {
+    private:
+        cv::BackgroundSubtractor *sub;
+        unsigned int scale;
+        bool refine;
+        cv::Mat kernel;
+        cv::Mat small_image;
+        cv::Mat small_mask;
+
+        ScaledBackgroundSubtractor(const ScaledBackgroundSubtractor &);
+        ScaledBackgroundSubtractor & operator=(const ScaledBackgroundSubtractor &);
+
+    public:
+        /**
+         * Create a new subtractor.
+         *
+         * @param[in] sub Subtractor that models the downscaled frames. It is
+         *                deleted together with this object.
+         * @param[in] scale Downscale factor, e.g. 2 or 4. 1 means the frame
+         *                  is processed at full resolution.
+         * @param[in] refine Smooth mask edges by linear interpolation
+         *                   instead of replicating the mask pixels.
+         *
+         * @throws logic_error if 'scale' is zero.
+         */
+        ScaledBackgroundSubtractor(cv::BackgroundSubtractor *sub,
+                                   unsigned int scale,
+                                   bool refine = false);
+
+        ~ScaledBackgroundSubtractor();
+
+        /**
+         * Compute foreground mask of 'image' and update the background
+         * model. The mask contains 255 for foreground and 0 for background.
+         */
+        void operator()(cv::InputArray image, cv::OutputArray fgmask,
+                        double learningRate = 0);
+
+        /**
+         * Get the background image upsampled to the last frame size.
+         */
+        void getBackgroundImage(cv::OutputArray image) const;
+
+        /**
+         * @return Downscale factor.
+         */
+        unsigned int getScale() const;
+
+        /**
+         * @return The wrapped subtractor.
+         */
+        cv::BackgroundSubtractor *getSubtractor() const;
+    };
+
+    /**
+     * MOG2 background subtractor whose trained model can be saved and
+     * restored, so a restarted process does not have to learn the
+     * background again.
+     */
+    class PersistentBackgroundSubtractorMOG2 : public cv::BackgroundSubtractorMOG2
+    {
+    public:
+        PersistentBackgroundSubtractorMOG2();
+
+        /**
+         * @see cv::BackgroundSubtractorMOG2
+         */
+        PersistentBackgroundSubtractorMOG2(int history, float varThreshold,
+                                           bool bShadowDetection = true);
+
+        /**
+         * Write the model into a binary stream. The stream must be opened
+         * in binary mode.
+         *
+         * @throws logic_error if the model was not trained yet.
+         * @throws runtime_error if the model can not be written.
+         */
+        void saveModel(std::ostream &out) const;
+
+        /**
+         * Restore the model from a binary stream.
+         *
+         * @return False if the stream does not contain a model compatible
+         *         with this subtractor.
+         */
+        bool loadModel(std::istream &in);
+
+        /**
+         * Save the model into 'filename'.
+         *
+         * @throws logic_error if the model was not trained yet.
+         * @throws runtime_error if the file can not be written.
+         */
+        void saveModel(const std::string &filename) const;
+
+        /**
+         * Load the model from 'filename'.
+         *
+         * @return False if the file can not be read or the model is not
+         *         compatible with this subtractor.
+         */
+        bool loadModel(const std::string &filename);
+
+        /**
+         * @return True if the subtractor processed at least one frame.
+         */
+        bool isTrained() const;
+    };
+
+    /**
+     * Background subtractor for static cameras that keeps an exponential
+     * running average and variance of each pixel.
+     *
+     * All arithmetic is in fixed point: the mean in Q8.23 and the
+     * variance in Q16.16, with the learning rate rounded to a power of two
+     * so the update is a rounding shift. Rows are processed by branch-free
+     * loops that the compiler vectorises, and row stripes run in parallel.
+     *
+     * A pixel is foreground if the squared difference from the mean of
+     * any channel exceeds 'var_threshold' times the variance. Only 8-bit
+     * images with 1 to 4 channels are supported.
+     */
+    class RunningAverageBackgroundSubtractor : public cv::BackgroundSubtractor
+    {
+    private:
+        cv::Mat mean;
+        cv::Mat variance;
+        cv::Size size;
+        int type;
+        unsigned int shift;
+        unsigned int var_threshold;
+        uint32_t var_init;
+        uint32_t var_min;
+
+    public:
+        /**
+         * Create a new subtractor.
+         *
+         * @param[in] shift Default learning rate is 2^-shift.
+         * @param[in] var_threshold Threshold on squared distance from the
+         *                          mean in units of variance, as in MOG2
+         *                          (1 - 255).
+         * @param[in] var_init Variance of a new model.
+         * @param[in] var_min Minimal variance, limits sensitivity to noise
+         *                    in very stable areas.
+         */
+        RunningAverageBackgroundSubtractor(unsigned int shift = 7,
+                                           float var_threshold = 16.0,
+                                           float var_init = 225.0,
+                                           float var_min = 16.0);
+
+        /**
+         * Compute foreground mask of 'image' and update the model.
+         *
+         * @param[in] image 8-bit image.
+         * @param[out] fgmask Mask with 255 for foreground, 0 otherwise.
+         * @param[in] learningRate Negative value means the default rate,
+         *                         zero disables the update, otherwise it
+         *                         is rounded to the nearest power of two
+         *                         (at least 2^-20). 1 resets the model.
+         *
+         * @throws logic_error if the image format is not supported.
+         */
+        void operator()(cv::InputArray image, cv::OutputArray fgmask,
+                        double learningRate = -1);
+
+        /**
+         * Get the mean image.
+         */
+        void getBackgroundImage(cv::OutputArray image) const;
+    };
+}
+
+#endif /* ODF_BACKGROUND_H_ */
@@ -0,0 +1,142 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_BOUNDEDQUEUE_H_
+#define ODF_BOUNDEDQUEUE_H_
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+namespace ODF
+{
+    /**
+     * Bounded lock-free multi-producer/multi-consumer queue.
+     *
+     * Each cell carries a sequence number that tells producers and
+     * consumers whether it is ready to be written or read, so the only
+     * contended operations are single compare-and-swaps on the head and
+     * tail positions.
+     *
+     * Blocking calls spin for a short while and then sleep on a condition
+     * variable. The lock is only taken when a thread is sleeping.
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+
+        std::unique_ptr<Cell[]> buffer;
+        size_t mask;
+
+        /* keep positions on separate cache lines */
+        char pad0[64];
+        std::atomic<size_t> enqueue_pos;
+        char pad1[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> dequeue_pos;
+        char pad2[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<bool> closed;
+
+        /* threads sleeping in push() and pop() */
+        std::atomic<unsigned int> push_waiters;
+        std::atomic<unsigned int> pop_waiters;
+        std::mutex lock;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+
+        BoundedQueue(const BoundedQueue &);
+        BoundedQueue & operator=(const BoundedQueue &);
+
+    public:
+        /**
+         * Create a new queue.
+         *
+         * @param[in] capacity Maximum number of queued items, rounded up to
+         *                     the nearest power of two.
+         */
+        BoundedQueue(size_t capacity);
+
+        /**
+         * Append 'value' if there is a free slot.
+         *
+         * @return True if the value was queued, false if the queue is full.
+         */
+        bool tryPush(const T &value);
+
+        /**
+         * Remove the oldest value if there is any.
+         *
+         * @return True if a value was dequeued, false if the queue is empty.
+         */
+        bool tryPop(T &value);
+
+        /**
+         * Append 'value', waiting while the queue is full.
+         *
+         * @return False if the queue was closed before the value was queued.
+         */
+        bool push(const T &value);
+
+        /**
+         * Remove the oldest value, waiting while the queue is empty.
+         *
+         * @return False if the queue is closed and empty.
+         */
+        bool pop(T &value);
+
+        /**
+         * Close the queue. Remaining values can still be dequeued, but
+         * blocked and further calls of BoundedQueue::push() fail.
+         */
+        void close();
+
+        /**
+         * @return True if the queue was closed.
+         */
+        bool isClosed() const;
+
+        /**
+         * @return Maximum number of queued items.
+         */
+        size_t capacity() const;
+
+    private:
+        bool enqueue(const T &value);
+        bool dequeue(T &value);
+        void wake(std::atomic<unsigned int> &waiters,
+                  std::condition_variable &cond);
+    };
+}
+
+/* include definition of templated methods */
+#include <odf/private/boundedqueue.cpp.h>
+
+#endif /* ODF_BOUNDEDQUEUE_H_ */
@@ -112,12 +112,15 @@ namespace ODF
          * Get fill ratio of the best fit box.
          */
         double getFillRatio() const;
+
+        friend class BoundingBoxVector;
     };
 
     class BoundingBoxVector
     {
     private:
         std::vector<BoundingBox> vector;
+        std::vector<int> rects; /* x, y, width, height of each bounding box */
         SAT sat;
         unsigned int area;
         bool area_set;
@@ -167,6 +170,21 @@ namespace ODF
          */
         void push(const cv::Rect &rect, double fill_ratio);
 
+        /**
+         * Push existing bounding box. It is merged into a bounding box that
+         * intersects it, otherwise it is added as it is.
+         *
+         * @param[in] box Bounding box.
+         */
+        void push(const BoundingBox &box);
+
+        /**
+         * Append bounding box without merging it with the others.
+         *
+         * @param[in] box Bounding box.
+         */
+        void append(const BoundingBox &box);
+
         /**
          * @return Number of elements in the vector.
          */
@@ -178,7 +196,8 @@ namespace ODF
         bool empty() const;
 
         /**
-         * @return Iterator to beginning.
+         * @return Iterator to beginning. Boxes must not be expanded through
+         *         it, later pushes would not merge with the new area.
          */
         iterator begin();
 
@@ -216,6 +235,10 @@ namespace ODF
          * @return Constant reverse iterator to end.
          */
         const_reverse_iterator rend() const;
+
+    private:
+        iterator findIntersection(const cv::Rect &rect);
+        void updateRect(iterator it);
     };
 }
 
@@ -0,0 +1,151 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_CLASSIFIER_H_
+#define ODF_CLASSIFIER_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <stdint.h>
+#include <odf/ruleset.h>
+
+namespace ODF
+{
+    /**
+     * Rule set compiled into three tables of 256 rule masks, one per
+     * channel. Bit k of table c at value v is set if rule k allows v in
+     * channel c, so a pixel may match the rules whose bits are set in all
+     * three lookups. Cross channel comparisons clear bits of the rules
+     * they fail and the lowest remaining bit is the first matching rule.
+     *
+     * The tables take 3 KB and the result is the same as of the rule set,
+     * without a branch per rule.
+     */
+    class BitsetClassifier
+    {
+    public:
+        /**
+         * Maximum number of rules.
+         */
+        static const unsigned int MaxRules = 32;
+
+        /**
+         * Compile 'rules'.
+         *
+         * @throws logic_error if there are more than MaxRules rules.
+         */
+        BitsetClassifier(const RuleSet &rules);
+
+        /**
+         * Load rules from 'rules_file' (see RuleSet::load()) and compile
+         * them. If 'cache_file' is given, tables compiled from the same
+         * content of the rules file are read from it instead, otherwise
+         * they are written into it for the next time.
+         *
+         * @param[in] rules_file Rule file.
+         * @param[in] cache_file Compiled tables, empty means no cache.
+         *
+         * @throws runtime_error if the rules can not be read or parsed.
+         * @throws logic_error if there are more than MaxRules rules.
+         */
+        static BitsetClassifier load(const std::string &rules_file,
+                                     const std::string &cache_file = "");
+
+        /**
+         * Save compiled tables into 'filename'. The file is in native byte
+         * order.
+         *
+         * @throws runtime_error if the file can not be written.
+         */
+        void save(const std::string &filename) const;
+
+        /**
+         * Threshold function.
+         *
+         * @return Result of the first rule matching 'value'.
+         */
+        bool operator()(const cv::Vec3b &value) const
+        {
+            const int c0 = value[0];
+            const int c1 = value[1];
+            const int c2 = value[2];
+            uint32_t m = this->tables[0][c0] & this->tables[1][c1]
+                         & this->tables[2][c2];
+
+            /* the sign of b - a keeps rules of pair (a, b) where a > b */
+            m &= ~this->pairs[0] | (uint32_t)((c1 - c0) >> 31);
+            m &= ~this->pairs[1] | (uint32_t)((c2 - c0) >> 31);
+            m &= ~this->pairs[2] | (uint32_t)((c2 - c1) >> 31);
+            m &= ~this->pairs[3] | (uint32_t)((c0 - c1) >> 31);
+            m &= ~this->pairs[4] | (uint32_t)((c0 - c2) >> 31);
+            m &= ~this->pairs[5] | (uint32_t)((c1 - c2) >> 31);
+
+            /* no rule left means fallback */
+            return ((m & (0u - m) & this->decisive) != 0) != this->fallback;
+        }
+
+        /**
+         * Classify 'count' pixels with three channels, write 255 for
+         * accepted and 0 for rejected pixels into 'out'. Uses the best
+         * kernel the processor supports.
+         */
+        void classify(const uchar *pixels, uchar *out, size_t count) const;
+
+        /**
+         * @return Number of rules.
+         */
+        unsigned int size() const;
+
+        /**
+         * @return Result of pixels no rule matches.
+         */
+        bool getFallback() const;
+
+        /**
+         * @return cv::COLOR_*2* value to pass to Image methods.
+         */
+        unsigned int getConversion() const;
+
+    private:
+        uint32_t tables[3][256];
+
+        /* rules needing value[a] > value[b], pair k is a = k / 2 and
+         * b = (a + 1 + k % 2) % 3 */
+        uint32_t pairs[6];
+
+        /* rules whose result differs from fallback */
+        uint32_t decisive;
+        unsigned int num_rules;
+        bool fallback;
+        unsigned int conversion;
+
+        /* hash of the rule file, zero if compiled in memory */
+        uint64_t source;
+
+        BitsetClassifier();
+
+        bool loadTables(const std::string &filename, uint64_t source);
+    };
+}
+
+#endif /* ODF_CLASSIFIER_H_ */
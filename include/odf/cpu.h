@@ -0,0 +1,67 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_CPU_H_
+#define ODF_CPU_H_
+
+namespace ODF
+{
+    /**
+     * Instruction set level of the vectorised kernels.
+     *
+     * The kernels are compiled for every level the compiler supports and
+     * the best one the processor can run is selected once when the
+     * library is loaded. Environment variable ODF_CPU_LEVEL (generic,
+     * sse4, avx2 or avx512) can force a lower level for testing; a level
+     * the processor does not support is never used. Unknown or unusable
+     * values are reported on stderr.
+     */
+    class CPU
+    {
+    public:
+        enum Level {
+            Generic,
+            SSE4,
+            AVX2,
+            AVX512
+        };
+
+        /**
+         * @return Level of the kernels that are in use.
+         */
+        static Level getLevel();
+
+        /**
+         * @return Highest level supported by both the processor and the
+         *         library build.
+         */
+        static Level getSupportedLevel();
+
+        /**
+         * @return Lower case name of the level, e.g. "avx2".
+         */
+        static const char * getLevelName(Level level);
+    };
+}
+
+#endif /* ODF_CPU_H_ */
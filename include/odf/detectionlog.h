@@ -0,0 +1,103 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_DETECTIONLOG_H_
+#define ODF_DETECTIONLOG_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <stdint.h>
+#include <odf/boundingbox.h>
+
+namespace ODF
+{
+    /**
+     * Record of detected objects, one entry per frame.
+     *
+     * JSONL format writes one JSON object per line:
+     *
+     *   {"frame":0,"name":"img.png","boxes":[{"x":..,"y":..,"w":..,"h":..,
+     *    "best":[x,y,w,h],"fill":..}]}
+     *
+     * Binary format starts with 8 bytes magic "ODFDETv1", then for each
+     * frame (little endian):
+     *
+     *   uint64 frame, uint16 name length, name, uint32 number of boxes,
+     *   and for each box int32 x, y, w, h of the bounding box, int32 x, y,
+     *   w, h of the best fit box and float32 fill ratio.
+     */
+    class DetectionLog
+    {
+    public:
+        enum Format {
+            JSONL,
+            Binary
+        };
+
+        /**
+         * Create a new log, existing file is overwritten.
+         *
+         * @param[in] filename Output file.
+         * @param[in] format Output format.
+         *
+         * @throws runtime_error if the file can not be created.
+         */
+        DetectionLog(const std::string &filename, Format format);
+
+        /**
+         * Append detections of one frame. It is safe to call this method
+         * from multiple threads.
+         *
+         * @param[in] frame Frame number.
+         * @param[in] name Frame name.
+         * @param[in] objects Detected objects.
+         *
+         * @throws runtime_error if the record can not be written.
+         */
+        void write(uint64_t frame, const std::string &name,
+                   const BoundingBoxVector &objects);
+
+        /**
+         * Flush buffered records to the file.
+         */
+        void flush();
+
+    private:
+        std::ofstream file;
+        std::string filename;
+        Format format;
+        std::mutex mutex;
+
+        DetectionLog(const DetectionLog &);
+        DetectionLog & operator=(const DetectionLog &);
+
+        void writeJSON(uint64_t frame, const std::string &name,
+                       const BoundingBoxVector &objects);
+        void writeBinary(uint64_t frame, const std::string &name,
+                         const BoundingBoxVector &objects);
+    };
+}
+
+#endif /* ODF_DETECTIONLOG_H_ */
@@ -0,0 +1,185 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_FRAMESOURCE_H_
+#define ODF_FRAMESOURCE_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <odf/image.h>
+#include <odf/lazysequence.h>
+
+namespace ODF
+{
+    /**
+     * Stream of images to be processed.
+     */
+    class FrameSource
+    {
+    public:
+        virtual ~FrameSource();
+
+        /**
+         * Fetch next frame. The image belongs to the source and stays valid
+         * only until the next call. It may share its pixel buffer with the
+         * source, so clone it if you need to keep it.
+         *
+         * The image does not have to be opened yet, call Image::open() to
+         * load it.
+         *
+         * @return Next frame or NULL if there are no more frames.
+         */
+        virtual Image *next() = 0;
+
+        /**
+         * Run 'callback' on each frame.
+         *
+         * @param[in] callback Functor to be invoked.
+         */
+        template <typename Functor>
+        void run(Functor &callback);
+
+        /**
+         * Run 'callback' on each frame using 'num_threads' threads. Frames
+         * are fetched one by one and each thread gets its own copy of the
+         * frame.
+         *
+         * @see ImageSequence::run(Functor &, unsigned int)
+         */
+        template <typename Functor>
+        void run(Functor &callback, unsigned int num_threads);
+
+        /**
+         * Run 'callback' on each frame using 'num_threads' threads,
+         * delivering results in the order of frames.
+         *
+         * @see ImageSequence::runOrdered(Functor &, unsigned int)
+         */
+        template <typename Functor>
+        void runOrdered(Functor &callback, unsigned int num_threads);
+
+    private:
+        /* Fetches frames for Private::runParallel() in index order. */
+        class Accessor
+        {
+        private:
+            FrameSource *source;
+            bool copy;
+            mutable std::mutex mutex;
+            mutable std::condition_variable fetched_cond;
+            mutable size_t fetched;
+            mutable bool finished;
+
+        public:
+            Accessor(FrameSource *source, bool copy);
+
+            size_t size() const;
+
+            Image *operator()(size_t index, std::unique_ptr<Image> &storage) const;
+        };
+    };
+
+    /**
+     * Frames decoded by cv::VideoCapture from a video file or a capture
+     * device (e.g. V4L2 camera). The pixel buffer is reused for all frames.
+     *
+     * Frames are named VIDEO-NUMBER.EXTENSION where VIDEO is the video file
+     * name without extension (or cameraDEVICE) and NUMBER is zero padded
+     * frame number, so they can be saved with Image::save("dir/%n").
+     */
+    class VideoSource : public FrameSource
+    {
+    private:
+        cv::VideoCapture capture;
+        std::string basename;
+        std::string extension;
+        unsigned int index;
+        cv::Mat buffer;
+        Image frame;
+
+    public:
+        /**
+         * Open video file or device path 'filename'.
+         *
+         * @param[in] filename Video file or device path.
+         * @param[in] extension Extension used in frame names.
+         *
+         * @throws runtime_error if the video can not be opened.
+         */
+        VideoSource(const std::string &filename,
+                    const std::string &extension = "png");
+
+        /**
+         * Open capture device number 'device'.
+         *
+         * @param[in] device Device number (e.g. 0 for /dev/video0).
+         * @param[in] extension Extension used in frame names.
+         *
+         * @throws runtime_error if the device can not be opened.
+         */
+        VideoSource(int device, const std::string &extension = "png");
+
+        Image *next();
+    };
+
+    /**
+     * Images of ODF::ImageSequence. The images are not opened.
+     */
+    class ImageSequenceSource : public FrameSource
+    {
+    private:
+        ImageSequence *sequence;
+        ImageSequence::iterator it;
+        bool started;
+
+    public:
+        ImageSequenceSource(ImageSequence &sequence);
+
+        Image *next();
+    };
+
+    /**
+     * Images of ODF::LazyImageSequence. The images are not opened.
+     */
+    class LazyImageSequenceSource : public FrameSource
+    {
+    private:
+        const LazyImageSequence *sequence;
+        std::unique_ptr<Image> current;
+        size_t index;
+
+    public:
+        LazyImageSequenceSource(const LazyImageSequence &sequence);
+
+        Image *next();
+    };
+}
+
+/* include definition of templated methods */
+#include <odf/private/framesource.cpp.h>
+
+#endif /* ODF_FRAMESOURCE_H_ */
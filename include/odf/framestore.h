@@ -0,0 +1,216 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_FRAMESTORE_H_
+#define ODF_FRAMESTORE_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include <stdint.h>
+#include <odf/image.h>
+#include <odf/framesource.h>
+
+/**
+ * Alignment of rows in the frame store [bytes].
+ */
+#define ODF_FRAMESTORE_ROW_ALIGN 64
+
+/**
+ * Alignment of frames in the frame store [bytes].
+ */
+#define ODF_FRAMESTORE_FRAME_ALIGN 4096
+
+/**
+ * Space reserved for each frame name in the frame store [bytes].
+ */
+#define ODF_FRAMESTORE_NAME_SIZE 256
+
+namespace ODF
+{
+    /**
+     * Raw frame store.
+     *
+     * A file that contains already decoded (and optionally converted)
+     * frames of equal size and type, so repeated runs over the same images
+     * do not need to decode them again. The file is memory mapped and
+     * images read from the store point directly into the mapping.
+     *
+     * The mapping is private, so painting into the images does not change
+     * the file.
+     *
+     * File layout:
+     * * header, padded to ODF_FRAMESTORE_FRAME_ALIGN
+     * * frames, each aligned to ODF_FRAMESTORE_FRAME_ALIGN with rows aligned
+     *   to ODF_FRAMESTORE_ROW_ALIGN
+     * * frame names, ODF_FRAMESTORE_NAME_SIZE bytes each
+     */
+    class FrameStore
+    {
+    private:
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t convert_to;
+            uint64_t count;
+            int32_t rows;
+            int32_t cols;
+            int32_t type;
+            int32_t reserved;
+            uint64_t step;
+            uint64_t frame_size;
+            uint64_t data_offset;
+            uint64_t names_offset;
+        };
+
+        std::string filename;
+        uchar *map;
+        size_t map_size;
+        const Header *header;
+
+        FrameStore(const FrameStore &);
+        FrameStore & operator=(const FrameStore &);
+
+        static bool isValid(const Header *header, size_t size);
+
+    public:
+        /**
+         * Open and map frame store 'filename'.
+         *
+         * @param[in] filename Frame store file.
+         *
+         * @throws runtime_error if the file can not be mapped or it is not
+         *         a valid frame store.
+         */
+        FrameStore(const std::string &filename);
+
+        /**
+         * Unmap the store. Images obtained from the store must not be used
+         * after the store is destroyed.
+         */
+        ~FrameStore();
+
+        /**
+         * Write all frames of 'source' into a new frame store 'filename'.
+         * Frames that can not be opened are skipped.
+         *
+         * @param[in] filename Frame store file.
+         * @param[in] source Frames to be stored.
+         * @param[in] convert_to cv::COLOR_*2* value to store converted
+         *                       frames, cv::COLOR_COLORCVT_MAX to store
+         *                       frames as they are.
+         *
+         * @return Number of stored frames.
+         *
+         * @throws runtime_error if the file can not be written or frames
+         *         have different size or type.
+         */
+        static size_t create(const std::string &filename,
+                             FrameSource &source,
+                             unsigned int convert_to = cv::COLOR_COLORCVT_MAX);
+
+        /**
+         * @return Number of frames in the store.
+         */
+        size_t size() const;
+
+        /**
+         * @return Conversion applied to the stored frames or
+         *         cv::COLOR_COLORCVT_MAX if they were stored as they are.
+         */
+        unsigned int getConversion() const;
+
+        /**
+         * Get opened image at position 'index'. The pixel data are not
+         * copied, the image points into the mapped file.
+         *
+         * @throws out_of_range if 'index' is not inside the store.
+         */
+        Image operator[](size_t index) const;
+
+        /**
+         * Run 'callback' on each frame.
+         *
+         * @param[in] callback Functor to be invoked.
+         */
+        template <typename Functor>
+        void run(Functor &callback);
+
+        /**
+         * Run 'callback' on each frame using 'num_threads' threads. The
+         * frames are not copied.
+         *
+         * @see ImageSequence::run(Functor &, unsigned int)
+         */
+        template <typename Functor>
+        void run(Functor &callback, unsigned int num_threads);
+
+        /**
+         * Run 'callback' on each frame using 'num_threads' threads,
+         * delivering results in the order of frames. The frames are not
+         * copied.
+         *
+         * @see ImageSequence::runOrdered(Functor &, unsigned int)
+         */
+        template <typename Functor>
+        void runOrdered(Functor &callback, unsigned int num_threads);
+
+    private:
+        /* Creates images for Private::runParallel(). */
+        class Accessor
+        {
+        private:
+            const FrameStore *store;
+
+        public:
+            Accessor(const FrameStore *store);
+
+            size_t size() const;
+
+            Image *operator()(size_t index, std::unique_ptr<Image> &storage) const;
+        };
+    };
+
+    /**
+     * Frames of ODF::FrameStore. The frames are not copied.
+     */
+    class FrameStoreSource : public FrameSource
+    {
+    private:
+        const FrameStore *store;
+        std::unique_ptr<Image> current;
+        size_t index;
+
+    public:
+        FrameStoreSource(const FrameStore &store);
+
+        Image *next();
+    };
+}
+
+/* include definition of templated methods */
+#include <odf/private/framestore.cpp.h>
+
+#endif /* ODF_FRAMESTORE_H_ */
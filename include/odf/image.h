@@ -26,10 +26,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <opencv2/opencv.hpp>
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <stdexcept>
+#include <stdint.h>
 #include <odf/boundingbox.h>
+#include <odf/roi.h>
 
 /*
  * HSV convertion macros.
@@ -69,6 +74,43 @@ namespace ODF
      */
     enum hsv_index {HUE, SAT, VAL};
 
+    class BitsetClassifier;
+    class ThreadPool;
+
+    /**
+     * Masks and worker threads that Image::getForegroundMask() keeps
+     * between frames. Use one object per set of subtractors, from one
+     * thread at a time.
+     */
+    class ForegroundBuffers
+    {
+    private:
+        friend class Image;
+
+        std::vector<cv::Mat> masks;
+        std::vector<bool> cleaned;
+        std::unique_ptr<ThreadPool> pool;
+
+        ForegroundBuffers(const ForegroundBuffers &);
+        ForegroundBuffers & operator=(const ForegroundBuffers &);
+
+    public:
+        ForegroundBuffers();
+        ~ForegroundBuffers();
+
+        /**
+         * Tell that subtractor 'index' cleans its mask itself, e.g.
+         * ScaledBackgroundSubtractor, so no morphological opening is
+         * applied on it.
+         */
+        void setCleaned(size_t index, bool cleaned = true);
+
+        /**
+         * @return True if subtractor 'index' cleans its mask itself.
+         */
+        bool isCleaned(size_t index) const;
+    };
+
     class Image
     {
     private:
@@ -78,6 +120,12 @@ namespace ODF
 
         cv::Mat image;
         bool is_opened;
+        std::shared_ptr<const RegionOfInterest> roi;
+
+        /* converted processed area, by cv::COLOR_*2* code; filled by const
+         * threshold methods, which may run in several threads at once */
+        mutable std::map<unsigned int, cv::Mat> conversions;
+        mutable std::mutex conversions_lock;
     public:
         static const cv::Scalar Red;
         static const cv::Scalar Green;
@@ -97,6 +145,56 @@ namespace ODF
          */
         Image(const std::string &filename);
 
+        /**
+         * Create a new opened image object associated with image 'filename'
+         * whose content is 'image'. The matrix data is not copied.
+         *
+         * @param[in] filename Image file, used to derive name and path.
+         * @param[in] image Image matrix.
+         */
+        Image(const std::string &filename, const cv::Mat &image);
+
+        /**
+         * Create a new opened image object that wraps caller owned pixel
+         * buffer 'data'. The data are not copied and the buffer must stay
+         * valid as long as the image (or any matrix obtained from it) is
+         * used.
+         *
+         * @param[in] filename Image file, used to derive name and path.
+         * @param[in] rows Number of rows.
+         * @param[in] cols Number of columns.
+         * @param[in] type Matrix type, e.g. CV_8UC3.
+         * @param[in] data Pixel buffer.
+         * @param[in] step Number of bytes between rows (AUTO_STEP means no
+         *                 padding).
+         */
+        Image(const std::string &filename, int rows, int cols, int type,
+              void *data, size_t step = cv::Mat::AUTO_STEP);
+
+        Image(const Image &other);
+        Image & operator=(const Image &other);
+
+        /**
+         * Create a deep copy of the image. If the image is opened, the
+         * pixel data are copied too.
+         */
+        Image clone() const;
+
+        /**
+         * Get part of the image. The rectangle is enlarged by 'padding'
+         * pixels on each side and clipped to the image. Pixel data are
+         * shared with this image.
+         *
+         * @param[in] rect Region to crop.
+         * @param[in] padding Number of pixels added around the region.
+         *
+         * @return Image with the same file name that contains the region.
+         *
+         * @throws logic_error if the image is not opened or the region
+         *         does not intersect the image.
+         */
+        Image crop(const cv::Rect &rect, unsigned int padding = 0) const;
+
         /**
          * Load the image into memory.
          * If the image is already opened, it is a noop.
@@ -151,12 +249,31 @@ namespace ODF
         bool save(std::string filename) const;
 
         /**
-         * Replace current image matrix with a new one.
+         * Expand the format used by Image::save() for this image.
+         *
+         * @param[in] filename File name with printf style format.
+         *
+         * @return File name where the image would be saved.
+         */
+        std::string formatFilename(std::string filename) const;
+
+        /**
+         * Replace current image matrix with a new one. The matrix data is
+         * not copied, the image shares it with 'new_image'.
          *
          * @param[in] new_image New image matrix.
          */
         void replaceImage(const cv::Mat &new_image);
 
+        /**
+         * Drop colour conversions remembered by threshold methods.
+         *
+         * Each conversion is computed once and reused until the image is
+         * changed through its own methods. Call this after modifying the
+         * matrix returned by Image::getImage() in place.
+         */
+        void invalidateConversions();
+
         /**
          * Applies mask on current image matrix.
          *
@@ -182,11 +299,37 @@ namespace ODF
          * condition change in time. In this case you can provide several
          * subtractors for different lighting conditions.
          *
+         * The subtractors run concurrently, so each of them must be used
+         * by one image at a time. Use ScaledBackgroundSubtractor to model
+         * the background at lower resolution.
+         *
+         * This starts worker threads on every call, pass ForegroundBuffers
+         * to keep them when processing a sequence.
+         *
+         * @param[in] subs Vector of pointers to background subtractors.
+         *
+         * @throws logic_error if the image is not opened.
+         */
+        cv::Mat getForegroundMask(const std::vector<cv::BackgroundSubtractor*> &subs) const;
+
+        /**
+         * Compute foreground mask using several background subtractors,
+         * reusing memory and threads from previous calls.
+         *
+         * The first subtractor runs in the calling thread, the others on
+         * threads owned by 'buffers'. Masks are cleaned by morphological
+         * opening unless ForegroundBuffers::setCleaned() says otherwise.
+         *
          * @param[in] subs Vector of pointers to background subtractors.
+         * @param[in,out] buffers Per subtractor masks and threads, keep
+         *                        them between calls.
+         * @param[out] mask Foreground mask.
          *
          * @throws logic_error if the image is not opened.
          */
-        cv::Mat getForegroundMask(std::vector<cv::BackgroundSubtractor*> subs) const;
+        void getForegroundMask(const std::vector<cv::BackgroundSubtractor*> &subs,
+                               ForegroundBuffers &buffers,
+                               cv::Mat &mask) const;
 
         /**
          * Paint rectangle in image for each bounding box in 'objects'.
@@ -268,6 +411,10 @@ namespace ODF
          * Threshold image using function 'fn'. Convert the image to
          * 'convert_to' format first, then threshold.
          *
+         * The converted image is kept, so thresholding the same image
+         * again in the same colour space does not convert it again.
+         * Concurrent threshold calls on one image object are not safe.
+         *
          * @param[in] fn bool threshold(const cv::Vec<uchar, arity> &);
          * @param[in] convert_to cv::COLOR_*2* values.
          *
@@ -482,6 +629,99 @@ namespace ODF
                                   const cv::Mat &mask,
                                   const cv::Vec<uchar, 3> &color);
 
+        /**
+         * Threshold image using compiled rules 'classifier'.
+         *
+         * @param[in] classifier Compiled rule set.
+         *
+         * @return Threshold mask.
+         *
+         * @throws logic_error if the image does not have three channels.
+         */
+        cv::Mat classify(const BitsetClassifier &classifier) const;
+
+        /**
+         * Threshold image using compiled rules 'classifier'. Apply mask on
+         * the image first, then threshold.
+         *
+         * @param[in] classifier Compiled rule set.
+         * @param[in] mask Image mask.
+         *
+         * @return Threshold mask.
+         *
+         * @throws logic_error if the image does not have three channels.
+         */
+        cv::Mat classify(const BitsetClassifier &classifier,
+                         const cv::Mat &mask) const;
+
+        /**
+         * Threshold image using compiled rules 'classifier'. Convert the
+         * image to 'convert_to' format first, then threshold.
+         *
+         * @param[in] classifier Compiled rule set.
+         * @param[in] convert_to cv::COLOR_*2* values.
+         *
+         * @return Threshold mask.
+         *
+         * @throws logic_error if the image does not have three channels.
+         */
+        cv::Mat classify(const BitsetClassifier &classifier,
+                         unsigned int convert_to) const;
+
+        /**
+         * Threshold image using compiled rules 'classifier'. Convert the
+         * image to 'convert_to' format first and apply 'mask', then
+         * threshold.
+         *
+         * @param[in] classifier Compiled rule set.
+         * @param[in] convert_to cv::COLOR_*2* values.
+         * @param[in] mask Image mask.
+         *
+         * @return Threshold mask.
+         *
+         * @throws logic_error if the image does not have three channels.
+         */
+        cv::Mat classify(const BitsetClassifier &classifier,
+                         unsigned int convert_to,
+                         const cv::Mat &mask) const;
+
+        /**
+         * Threshold image using several functions in a single pass.
+         * Convert the image to 'convert_to' format first and apply 'mask',
+         * then threshold.
+         *
+         * Bit k of the label mask is set where the k-th function accepts
+         * the pixel, so the image is read once however many classes are
+         * detected. Use Image::splitLabels() to get a threshold mask per
+         * function.
+         *
+         * @param[in] convert_to cv::COLOR_*2* values, COLOR_COLORCVT_MAX
+         *                       means no conversion.
+         * @param[in] mask Image mask, empty mask means no mask.
+         * @param[in] fns One to eight
+         *                bool threshold(const cv::Vec<uchar, arity> &);
+         *
+         * @return Label mask.
+         */
+        template <unsigned int arity = 3, typename... Functors>
+        cv::Mat thresholdLabels(unsigned int convert_to,
+                                const cv::Mat &mask,
+                                Functors &... fns) const;
+
+        /**
+         * Split label mask into threshold masks, one per class.
+         *
+         * @param[in] labels Label mask as returned by
+         *                   Image::thresholdLabels().
+         * @param[in] count Number of classes.
+         *
+         * @return Threshold mask of each class.
+         *
+         * @throws logic_error if 'count' is greater than eight.
+         */
+        static std::vector<cv::Mat> splitLabels(const cv::Mat &labels,
+                                                unsigned int count);
+
         /**
          * Get image name.
          */
@@ -492,6 +732,11 @@ namespace ODF
          */
         const std::string & getPath() const;
 
+        /**
+         * Get file name used in constructor.
+         */
+        const std::string & getFilename() const;
+
         /**
          * Get image matrix.
          *
@@ -499,11 +744,42 @@ namespace ODF
          */
         const cv::Mat & getImage() const;
 
+        /**
+         * Restrict processing to a static region of interest. Colour
+         * conversion and thresholding touch only pixels inside the region,
+         * background subtraction runs only on its bounding rectangle and
+         * the resulting masks are zero outside of the region. Background
+         * subtractors must therefore be trained on the same rectangle,
+         * otherwise they start a new model on the first frame.
+         *
+         * The image keeps the region alive, so the caller may replace its
+         * own region while images that use the old one are still queued.
+         *
+         * @param[in] roi Region of interest, empty means the whole image.
+         */
+        void setRegionOfInterest(const std::shared_ptr<const RegionOfInterest> &roi);
+
+        /**
+         * Get region of interest or NULL if the whole image is processed.
+         */
+        const RegionOfInterest * getRegionOfInterest() const;
+
     private:
-        void assertIsOpen() const throw (std::logic_error);
+        void setFilename(const std::string &filename);
+
+        void assertIsOpen() const;
+
+        cv::Rect _processedArea() const;
+
+        cv::Mat _thresholdGetImage(unsigned int convert_to,
+                                   const cv::Rect &area) const;
 
-        cv::Mat _thresholdGetImage(const cv::Mat *mask,
-                                   unsigned int convert_to) const;
+        void _countThreshold(uint64_t pixels, uint64_t masked,
+                             bool probed, unsigned int functors = 1) const;
+
+        cv::Mat _classify(const BitsetClassifier &classifier,
+                          const cv::Mat *input_mask,
+                          unsigned int convert_to) const;
 
         template <unsigned int arity, typename Functor>
         cv::Mat _threshold(Functor &threshold_fn,
@@ -633,6 +909,54 @@ namespace ODF
             }
         }
 
+        /**
+         * Run 'callback' on each image in image sequence using
+         * 'num_threads' threads. The images are processed concurrently and
+         * in no particular order.
+         *
+         * Each thread works with its own copy of 'callback', therefore the
+         * functor must be copy constructible and the copies must not share
+         * any unprotected state. If 'num_threads' is 1, the images are
+         * processed in the calling thread using 'callback' directly.
+         *
+         * This method does not manipulate with any image object.
+         *
+         * @param[in] callback Functor to be invoked.
+         * @param[in] num_threads Number of threads (0 means one thread per
+         *                        available CPU core).
+         *
+         * @throws the first exception thrown by any of the callbacks.
+         */
+        template <typename Functor>
+        void run(Functor &callback, unsigned int num_threads);
+
+        /**
+         * Run 'callback' on each image in image sequence using
+         * 'num_threads' threads, delivering results in sequence order.
+         *
+         * callback(Image *) is invoked concurrently exactly as with
+         * ImageSequence::run(callback, num_threads). Once it returns,
+         * callback.complete(Image *) is invoked on the same copy of
+         * 'callback', but only after complete() has returned for all
+         * preceding images in the sequence. Put side effects that must
+         * happen in order (console output, saving files) into complete().
+         *
+         * With more than one thread, complete() of consecutive images is
+         * called on different copies, so members of a copy see only the
+         * images that copy has processed. State that must follow the
+         * whole sequence (frame counters, results of the previous frame)
+         * has to be shared by all copies. It needs no locking if only
+         * complete() uses it, since those calls never overlap.
+         *
+         * @param[in] callback Functor to be invoked.
+         * @param[in] num_threads Number of threads (0 means one thread per
+         *                        available CPU core).
+         *
+         * @throws the first exception thrown by any of the callbacks.
+         */
+        template <typename Functor>
+        void runOrdered(Functor &callback, unsigned int num_threads);
+
     private:
         void createSequence(std::string dirpath,
                             const std::string &extension,
@@ -646,5 +970,6 @@ namespace ODF
 
 /* include definition of templated methods */
 #include <odf/private/image_threshold.cpp.h>
+#include <odf/private/image_sequence.cpp.h>
 
 #endif /* ODF_IMAGE_H_ */
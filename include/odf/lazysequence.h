@@ -0,0 +1,183 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_LAZYSEQUENCE_H_
+#define ODF_LAZYSEQUENCE_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <odf/image.h>
+
+namespace ODF
+{
+    /**
+     * Image sequence that creates Image objects only when they are needed.
+     *
+     * Numbered sequences compute file names from the index, so creating
+     * such a sequence takes constant time and memory regardless of its
+     * length. Directory listing and glob sources keep only the list of file
+     * names.
+     */
+    class LazyImageSequence
+    {
+    private:
+        enum source_type {NUMBERED, LIST};
+
+        source_type type;
+
+        /* numbered source */
+        std::string dirpath;
+        std::string extension;
+        std::string prefix;
+        std::string suffix;
+        unsigned short num_digits;
+        unsigned int range_start;
+        unsigned int range_end;
+
+        /* directory listing and glob source */
+        std::vector<std::string> filenames;
+
+    public:
+        /**
+         * Create sequence of images in directory 'dirpath' named
+         * 'prefix'NUMBER'suffix'.'extension' where NUMBER goes from
+         * 'range_start' to 'range_end' and is zero padded from left side to
+         * 'num_digits' digits. See ODF::ImageSequence.
+         *
+         * @param[in] dirpath Directory where the images are located.
+         * @param[in] extension Image extension.
+         * @param[in] prefix Prefix.
+         * @param[in] suffix Suffix.
+         * @param[in] num_digits Number of digits in image name (0 means do not pad).
+         * @param[in] range_start Range start.
+         * @param[in] range_end Range end.
+         */
+        LazyImageSequence(const std::string &dirpath,
+                          const std::string &extension,
+                          const std::string &prefix,
+                          const std::string &suffix,
+                          unsigned short num_digits,
+                          unsigned int range_start,
+                          unsigned int range_end);
+
+        /**
+         * Create sequence of all files in directory 'dirpath' with given
+         * 'extension', sorted by name.
+         *
+         * @param[in] dirpath Directory where the images are located.
+         * @param[in] extension Image extension (empty means any file).
+         *
+         * @throws runtime_error if the directory can not be read.
+         */
+        static LazyImageSequence fromDirectory(const std::string &dirpath,
+                                               const std::string &extension);
+
+        /**
+         * Create sequence of all files matching shell wildcard 'pattern',
+         * sorted by name.
+         *
+         * E. g.:
+         * LazyImageSequence::fromGlob("/my/images/CAM-*.png");
+         *
+         * @param[in] pattern Wildcard pattern.
+         *
+         * @throws runtime_error if the pattern can not be expanded.
+         */
+        static LazyImageSequence fromGlob(const std::string &pattern);
+
+        /**
+         * @return Number of images in the sequence.
+         */
+        size_t size() const;
+
+        /**
+         * @return True if the sequence is empty, false otherwise.
+         */
+        bool empty() const;
+
+        /**
+         * @return File name of image at position 'index'.
+         *
+         * @throws out_of_range if 'index' is not inside the sequence.
+         */
+        std::string getFilename(size_t index) const;
+
+        /**
+         * Create image at position 'index'. The image is not opened.
+         *
+         * @throws out_of_range if 'index' is not inside the sequence.
+         */
+        Image operator[](size_t index) const;
+
+        /**
+         * Run 'callback' on each image in image sequence. The image object
+         * exists only while the callback runs.
+         *
+         * @param[in] callback Functor to be invoked.
+         */
+        template <typename Functor>
+        void run(Functor &callback);
+
+        /**
+         * Run 'callback' on each image in image sequence using
+         * 'num_threads' threads.
+         *
+         * @see ImageSequence::run(Functor &, unsigned int)
+         */
+        template <typename Functor>
+        void run(Functor &callback, unsigned int num_threads);
+
+        /**
+         * Run 'callback' on each image in image sequence using
+         * 'num_threads' threads, delivering results in sequence order.
+         *
+         * @see ImageSequence::runOrdered(Functor &, unsigned int)
+         */
+        template <typename Functor>
+        void runOrdered(Functor &callback, unsigned int num_threads);
+
+    private:
+        LazyImageSequence(const std::vector<std::string> &filenames);
+
+        /* Creates images for Private::runParallel(). */
+        class Accessor
+        {
+        private:
+            const LazyImageSequence *sequence;
+
+        public:
+            Accessor(const LazyImageSequence *sequence);
+
+            size_t size() const;
+
+            Image *operator()(size_t index, std::unique_ptr<Image> &storage) const;
+        };
+    };
+}
+
+/* include definition of templated methods */
+#include <odf/private/lazysequence.cpp.h>
+
+#endif /* ODF_LAZYSEQUENCE_H_ */
@@ -0,0 +1,186 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_METRICS_H_
+#define ODF_METRICS_H_
+
+#include <string>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+namespace ODF
+{
+    /**
+     * Work counters of one frame, or of everything a thread did so far.
+     */
+    class FrameStats;
+
+    /**
+     * Registry of work counters updated by all processing stages.
+     *
+     * Each thread updates its own copy of the counters, so an update is
+     * a plain increment without locks or atomic read-modify-write. The
+     * totals are summed over all threads when they are read. Counters of
+     * threads that have already exited are kept.
+     */
+    class Metrics
+    {
+    public:
+        enum Counter {
+            PixelsThresholded,  /* pixels decided by threshold */
+            PixelsMasked,       /* of those, decided by the mask only */
+            FunctorCalls,       /* threshold functor invocations */
+            WindowsEvaluated,   /* sliding window positions tested */
+            WindowsAccepted,    /* windows above the fill threshold */
+            BoxMerges,          /* windows and boxes merged into a box */
+            BytesAllocated,     /* image buffers allocated by stages */
+            DecodeBytes,        /* pixel bytes produced by decoding */
+            EncodeBytes,        /* pixel bytes passed to encoding */
+            NumCounters
+        };
+
+        /**
+         * Add 'value' to 'counter' of the calling thread.
+         */
+        static void add(Counter counter, uint64_t value);
+
+        /**
+         * @return Sum of 'counter' over all threads.
+         */
+        static uint64_t get(Counter counter);
+
+        /**
+         * @return Counters summed over all threads.
+         */
+        static FrameStats total();
+
+        /**
+         * @return Counters of the calling thread. The difference of two
+         * values taken around a piece of work gives its statistics.
+         */
+        static FrameStats local();
+
+        /**
+         * @return Metric name of the counter, e.g. "pixels_thresholded".
+         */
+        static const char * getName(Counter counter);
+
+        /**
+         * @return One line description of the counter.
+         */
+        static const char * getHelp(Counter counter);
+
+        /**
+         * Write all counters in Prometheus text exposition format.
+         */
+        static void writePrometheus(std::ostream &stream);
+
+        /**
+         * Write all counters in Prometheus text exposition format into
+         * 'filename'. The file is replaced atomically so a scraper never
+         * sees a partial file.
+         *
+         * @return False if the file could not be written.
+         */
+        static bool dumpPrometheus(const std::string &filename);
+    };
+
+    class FrameStats
+    {
+    private:
+        uint64_t values[Metrics::NumCounters];
+
+    public:
+        /**
+         * Create statistics with all counters set to zero.
+         */
+        FrameStats();
+
+        uint64_t get(Metrics::Counter counter) const;
+
+        void set(Metrics::Counter counter, uint64_t value);
+
+        FrameStats & operator+=(const FrameStats &other);
+
+        FrameStats & operator-=(const FrameStats &other);
+
+        FrameStats operator-(const FrameStats &other) const;
+    };
+
+    /**
+     * Add work done by the calling thread during the lifetime of this
+     * object to 'stats'.
+     */
+    class MetricsScope
+    {
+    private:
+        FrameStats &stats;
+        FrameStats start;
+
+    public:
+        explicit MetricsScope(FrameStats &stats);
+
+        ~MetricsScope();
+
+    private:
+        MetricsScope(const MetricsScope &);
+        MetricsScope & operator=(const MetricsScope &);
+    };
+
+    /**
+     * Dump counters in Prometheus text format into a file periodically
+     * from a background thread. The file is written once more when the
+     * exporter is destroyed.
+     */
+    class MetricsExporter
+    {
+    private:
+        std::string filename;
+        unsigned int interval;
+        bool stopping;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::thread thread;
+
+    public:
+        /**
+         * @param[in] filename Output file, e.g. for node_exporter textfile
+         *                     collector.
+         * @param[in] interval Number of milliseconds between dumps.
+         */
+        MetricsExporter(const std::string &filename, unsigned int interval);
+
+        ~MetricsExporter();
+
+    private:
+        MetricsExporter(const MetricsExporter &);
+        MetricsExporter & operator=(const MetricsExporter &);
+
+        void run();
+    };
+}
+
+#endif /* ODF_METRICS_H_ */
@@ -0,0 +1,96 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_MOTIONGATE_H_
+#define ODF_MOTIONGATE_H_
+
+#include <opencv2/opencv.hpp>
+
+namespace ODF
+{
+    /**
+     * Cheap change detector used to skip frames without motion.
+     *
+     * The frame is subsampled to a grayscale grid and compared with the
+     * last frame that passed the gate. The difference is averaged over
+     * blocks; a block whose mean absolute difference exceeds the threshold
+     * is changed. If there is no changed block the frame can be skipped,
+     * otherwise only the region covering the changed blocks needs to be
+     * processed.
+     */
+    class MotionGate
+    {
+    public:
+        struct Result
+        {
+            /* true if the frame has to be processed */
+            bool motion;
+
+            /* area of changed blocks with one block of padding, in frame
+             * coordinates; the whole frame for the first frame */
+            cv::Rect roi;
+
+            /* number of changed blocks */
+            unsigned int changed;
+        };
+
+        /**
+         * Create a new gate.
+         *
+         * @param[in] block_size Block size in frame pixels.
+         * @param[in] subsample Only every n-th pixel in both directions is
+         *                      compared, must divide 'block_size'.
+         * @param[in] threshold Mean absolute difference of a block that
+         *                      marks it changed (0 - 255).
+         *
+         * @throws logic_error if the parameters are inconsistent.
+         */
+        MotionGate(unsigned int block_size = 16,
+                   unsigned int subsample = 4,
+                   double threshold = 8.0);
+
+        /**
+         * Compare 'frame' with the last frame that passed the gate. When
+         * motion is found, 'frame' becomes the new reference.
+         *
+         * @param[in] frame BGR or grayscale 8-bit frame.
+         */
+        Result check(const cv::Mat &frame);
+
+        /**
+         * Forget the reference frame, next frame always passes.
+         */
+        void reset();
+
+    private:
+        unsigned int block_size;
+        unsigned int subsample;
+        double threshold;
+        cv::Mat reference;
+        cv::Mat current;
+        cv::Mat diff;
+        cv::Mat blocks;
+    };
+}
+
+#endif /* ODF_MOTIONGATE_H_ */
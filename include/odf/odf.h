@@ -25,8 +25,26 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define ODF_H_
 
 #include <odf/image.h>
+#include <odf/lazysequence.h>
+#include <odf/framesource.h>
+#include <odf/framestore.h>
+#include <odf/shmframering.h>
+#include <odf/asyncwriter.h>
+#include <odf/detectionlog.h>
+#include <odf/resultcache.h>
+#include <odf/roi.h>
+#include <odf/background.h>
+#include <odf/motiongate.h>
 #include <odf/sat.h>
 #include <odf/boundingbox.h>
 #include <odf/slidingwindow.h>
+#include <odf/threadpool.h>
+#include <odf/boundedqueue.h>
+#include <odf/pipeline.h>
+#include <odf/trace.h>
+#include <odf/metrics.h>
+#include <odf/cpu.h>
+#include <odf/ruleset.h>
+#include <odf/classifier.h>
 
 #endif /* ODF_H_ */
@@ -0,0 +1,208 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_PIPELINE_H_
+#define ODF_PIPELINE_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <stdint.h>
+#include <odf/boundedqueue.h>
+
+namespace ODF
+{
+    /**
+     * A single processing step of ODF::Pipeline.
+     */
+    template <typename T>
+    class PipelineStage
+    {
+    public:
+        virtual ~PipelineStage() {}
+
+        /**
+         * Process 'item'. If the stage runs in more than one thread, this
+         * method is called concurrently and must be thread safe.
+         *
+         * @param[in,out] item Item to be processed.
+         *
+         * @return False to drop the item, it is not passed to any of the
+         *         following stages.
+         */
+        virtual bool process(T &item) = 0;
+    };
+
+    /**
+     * Run items of type T through a chain of stages. Stages are connected by
+     * bounded lock-free queues and each stage runs in its own thread(s), so
+     * the stages work on different items at the same time. A full queue
+     * blocks the stages in front of it.
+     *
+     * Items are numbered as they are pushed into the pipeline. An ordered
+     * stage always receives items in this order, which makes it possible to
+     * keep stateful stages (e.g. background subtraction) behind stages that
+     * run in several threads.
+     */
+    template <typename T>
+    class Pipeline
+    {
+    public:
+        struct Statistics
+        {
+            std::string name;
+            unsigned int num_threads;
+            bool ordered;
+
+            /** Number of items processed by the stage. */
+            uint64_t items;
+
+            /** Number of items dropped by the stage. */
+            uint64_t dropped;
+
+            /** Time spent in PipelineStage::process() [ms]. */
+            double busy_ms;
+
+            /** Time spent waiting for input [ms]. */
+            double starved_ms;
+
+            /** Time spent waiting for a free slot in the next stage [ms]. */
+            double blocked_ms;
+        };
+
+        /**
+         * Create an empty pipeline.
+         *
+         * @param[in] queue_capacity Capacity of queue in front of each stage.
+         */
+        Pipeline(size_t queue_capacity = 16);
+
+        /**
+         * Finish the pipeline if it is still running.
+         */
+        ~Pipeline();
+
+        /**
+         * Append a new stage. The pipeline does not take ownership of
+         * 'stage'. Stages can only be added before Pipeline::start().
+         *
+         * @param[in] name Stage name used in statistics.
+         * @param[in] stage Stage implementation.
+         * @param[in] num_threads Number of threads running the stage.
+         * @param[in] ordered Process items in the order in which they were
+         *                    pushed. Ordered stages always run in one thread.
+         *
+         * @throws logic_error if the pipeline is already running.
+         */
+        void addStage(const std::string &name,
+                      PipelineStage<T> *stage,
+                      unsigned int num_threads = 1,
+                      bool ordered = false);
+
+        /**
+         * Start all stage threads.
+         *
+         * @throws logic_error if there are no stages or the pipeline is
+         *         already running.
+         */
+        void start();
+
+        /**
+         * Push a new item into the pipeline, waiting while the first stage
+         * is busy. Items must be pushed from a single thread.
+         *
+         * @return False if the pipeline was stopped by an error.
+         *
+         * @throws logic_error if the pipeline is not running.
+         */
+        bool push(const T &item);
+
+        /**
+         * Wait until all pushed items pass through the pipeline and stop
+         * all threads.
+         *
+         * @throws the first exception that escaped from any stage.
+         */
+        void finish();
+
+        /**
+         * @return Statistics of each stage.
+         */
+        std::vector<Statistics> getStatistics() const;
+
+    private:
+        struct Envelope
+        {
+            uint64_t seq;
+            bool dropped;
+            T item;
+
+            Envelope() : seq(0), dropped(false), item() {}
+        };
+
+        typedef BoundedQueue<Envelope> Queue;
+
+        struct Stage
+        {
+            std::string name;
+            PipelineStage<T> *stage;
+            unsigned int num_threads;
+            bool ordered;
+
+            std::unique_ptr<Queue> input;
+            std::vector<std::thread> threads;
+            std::atomic<unsigned int> active;
+
+            std::atomic<uint64_t> items;
+            std::atomic<uint64_t> dropped;
+            std::atomic<uint64_t> busy_ns;
+            std::atomic<uint64_t> starved_ns;
+            std::atomic<uint64_t> blocked_ns;
+        };
+
+        std::vector<std::unique_ptr<Stage> > stages;
+        size_t queue_capacity;
+        uint64_t next_seq;
+        bool running;
+
+        std::atomic<bool> aborted;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        Pipeline(const Pipeline &);
+        Pipeline & operator=(const Pipeline &);
+
+        void worker(size_t index);
+        void handle(Stage *stage, Queue *output, Envelope &envelope);
+        void abort();
+    };
+}
+
+/* include definition of templated methods */
+#include <odf/private/pipeline.cpp.h>
+
+#endif /* ODF_PIPELINE_H_ */
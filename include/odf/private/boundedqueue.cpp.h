@@ -0,0 +1,267 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef BOUNDEDQUEUE_H_
+#define BOUNDEDQUEUE_H_
+
+#include <odf/boundedqueue.h>
+
+namespace ODF
+{
+    template <typename T>
+    BoundedQueue<T>::BoundedQueue(size_t capacity)
+        : buffer(),
+          mask(0),
+          enqueue_pos(0),
+          dequeue_pos(0),
+          closed(false),
+          push_waiters(0),
+          pop_waiters(0)
+    {
+        size_t size = 2;
+
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        this->buffer.reset(new Cell[size]);
+        this->mask = size - 1;
+
+        for (size_t i = 0; i < size; i++) {
+            this->buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::tryPush(const T &value)
+    {
+        if (!this->enqueue(value)) {
+            return false;
+        }
+
+        this->wake(this->pop_waiters, this->not_empty);
+        return true;
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::tryPop(T &value)
+    {
+        if (!this->dequeue(value)) {
+            return false;
+        }
+
+        this->wake(this->push_waiters, this->not_full);
+        return true;
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::enqueue(const T &value)
+    {
+        size_t pos = this->enqueue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        size_t seq;
+        ptrdiff_t diff;
+
+        while (true) {
+            cell = &this->buffer[pos & this->mask];
+            seq = cell->sequence.load(std::memory_order_acquire);
+            diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+            if (diff == 0) {
+                /* cell is free, try to claim it */
+                if (this->enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                /* queue is full */
+                return false;
+            } else {
+                /* another producer was faster */
+                pos = this->enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::dequeue(T &value)
+    {
+        size_t pos = this->dequeue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        size_t seq;
+        ptrdiff_t diff;
+
+        while (true) {
+            cell = &this->buffer[pos & this->mask];
+            seq = cell->sequence.load(std::memory_order_acquire);
+            diff = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+
+            if (diff == 0) {
+                /* cell is filled, try to claim it */
+                if (this->dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                /* queue is empty */
+                return false;
+            } else {
+                /* another consumer was faster */
+                pos = this->dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->data);
+        cell->data = T();
+        cell->sequence.store(pos + this->mask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::push(const T &value)
+    {
+        /* spin briefly, a consumer is usually about to free a cell */
+        for (unsigned int attempt = 0; attempt < 64; attempt++) {
+            if (this->isClosed()) {
+                return false;
+            }
+
+            if (this->tryPush(value)) {
+                return true;
+            }
+
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->push_waiters.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        while (!this->isClosed()) {
+            if (this->enqueue(value)) {
+                this->push_waiters.fetch_sub(1);
+                guard.unlock();
+                this->wake(this->pop_waiters, this->not_empty);
+                return true;
+            }
+
+            this->not_full.wait(guard);
+        }
+
+        this->push_waiters.fetch_sub(1);
+        return false;
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::pop(T &value)
+    {
+        bool popped = false;
+
+        for (unsigned int attempt = 0; attempt < 64; attempt++) {
+            if (this->tryPop(value)) {
+                return true;
+            }
+
+            if (this->isClosed()) {
+                /* a value may have been pushed just before closing */
+                return this->tryPop(value);
+            }
+
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->pop_waiters.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        while (true) {
+            if (this->dequeue(value)) {
+                popped = true;
+                break;
+            }
+
+            if (this->isClosed()) {
+                popped = this->dequeue(value);
+                break;
+            }
+
+            this->not_empty.wait(guard);
+        }
+
+        this->pop_waiters.fetch_sub(1);
+        guard.unlock();
+
+        if (popped) {
+            this->wake(this->push_waiters, this->not_full);
+        }
+
+        return popped;
+    }
+
+    template <typename T>
+    void BoundedQueue<T>::close()
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+
+        this->closed.store(true, std::memory_order_release);
+        this->not_full.notify_all();
+        this->not_empty.notify_all();
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::isClosed() const
+    {
+        return this->closed.load(std::memory_order_acquire);
+    }
+
+    template <typename T>
+    size_t BoundedQueue<T>::capacity() const
+    {
+        return this->mask + 1;
+    }
+
+    template <typename T>
+    void BoundedQueue<T>::wake(std::atomic<unsigned int> &waiters,
+                               std::condition_variable &cond)
+    {
+        /* pairs with the fence after a sleeper registers: either it sees
+         * our cell, or we see it waiting */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+
+        /* the sleeper checks and waits under the lock, so it can not miss
+         * this notification */
+        std::lock_guard<std::mutex> guard(this->lock);
+        cond.notify_all();
+    }
+}
+
+#endif /* BOUNDEDQUEUE_H_ */
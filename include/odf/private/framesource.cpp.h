@@ -0,0 +1,58 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FRAMESOURCE_H_
+#define FRAMESOURCE_H_
+
+#include <odf/framesource.h>
+
+namespace ODF
+{
+    template <typename Functor>
+    void FrameSource::run(Functor &callback)
+    {
+        Image *image;
+
+        while ((image = this->next()) != NULL) {
+            callback(image);
+        }
+    }
+
+    template <typename Functor>
+    void FrameSource::run(Functor &callback, unsigned int num_threads)
+    {
+        Private::runParallel<Functor, false>(callback,
+                                             Accessor(this, num_threads != 1),
+                                             num_threads);
+    }
+
+    template <typename Functor>
+    void FrameSource::runOrdered(Functor &callback, unsigned int num_threads)
+    {
+        Private::runParallel<Functor, true>(callback,
+                                            Accessor(this, num_threads != 1),
+                                            num_threads);
+    }
+}
+
+#endif /* FRAMESOURCE_H_ */
@@ -0,0 +1,191 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef IMAGE_SEQUENCE_H_
+#define IMAGE_SEQUENCE_H_
+
+#include <list>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <odf/image.h>
+#include <odf/threadpool.h>
+
+namespace ODF
+{
+    namespace Private
+    {
+        /* Invoke complete() only when ordered delivery was requested so
+         * plain functors do not need to provide it. */
+        template <typename Functor, bool ordered>
+        struct Completion
+        {
+            static void complete(Functor &callback, Image *image)
+            {
+                /* noop */
+            }
+        };
+
+        template <typename Functor>
+        struct Completion<Functor, true>
+        {
+            static void complete(Functor &callback, Image *image)
+            {
+                callback.complete(image);
+            }
+        };
+    }
+
+    namespace Private
+    {
+        /* Returns pointers to images stored in an ImageSequence. */
+        class ListAccessor
+        {
+        private:
+            std::vector<Image*> images;
+
+        public:
+            ListAccessor(std::list<Image> &list)
+            {
+                std::list<Image>::iterator it;
+
+                for (it = list.begin(); it != list.end(); it++) {
+                    this->images.push_back(&(*it));
+                }
+            }
+
+            size_t size() const
+            {
+                return this->images.size();
+            }
+
+            Image *operator()(size_t index, std::unique_ptr<Image> &storage) const
+            {
+                return this->images[index];
+            }
+        };
+
+        /**
+         * Invoke 'callback' on each image provided by 'accessor' using
+         * 'num_threads' threads. The accessor returns image at given index
+         * and may use 'storage' to own it. It returns NULL when there are
+         * no more images, which allows sources of unknown length.
+         */
+        template <typename Functor, bool ordered, typename Accessor>
+        void runParallel(Functor &callback,
+                         const Accessor &accessor,
+                         unsigned int num_threads)
+        {
+            std::unique_ptr<Image> storage;
+            std::atomic<size_t> next(0);
+            std::atomic<bool> aborted(false);
+            std::mutex mutex;
+            std::condition_variable turn;
+            size_t next_complete = 0; /* guarded by mutex */
+            size_t count = accessor.size();
+            Image *image;
+
+            if (num_threads == 1) {
+                for (size_t i = 0; i < count; i++) {
+                    image = accessor(i, storage);
+                    if (image == NULL) {
+                        break;
+                    }
+
+                    callback(image);
+                    Completion<Functor, ordered>::complete(callback, image);
+                }
+
+                return;
+            }
+
+            ThreadPool pool(num_threads);
+
+            for (unsigned int t = 0; t < pool.size(); t++) {
+                pool.submit([&]() {
+                    Functor worker(callback);
+                    std::unique_ptr<Image> local;
+                    Image *img;
+                    size_t i;
+
+                    try {
+                        while (!aborted && (i = next++) < count) {
+                            img = accessor(i, local);
+                            if (img == NULL) {
+                                break;
+                            }
+
+                            worker(img);
+
+                            if (!ordered) {
+                                continue;
+                            }
+
+                            /* wait until all preceding images are completed */
+                            std::unique_lock<std::mutex> lock(mutex);
+                            turn.wait(lock, [&]() {
+                                return aborted || next_complete == i;
+                            });
+
+                            if (aborted) {
+                                break;
+                            }
+
+                            Completion<Functor, ordered>::complete(worker, img);
+                            next_complete++;
+                            turn.notify_all();
+                        }
+                    } catch (...) {
+                        /* wake up threads waiting for their turn */
+                        std::lock_guard<std::mutex> lock(mutex);
+                        aborted = true;
+                        turn.notify_all();
+                        throw;
+                    }
+                });
+            }
+
+            pool.wait();
+        }
+    }
+
+    template <typename Functor>
+    void ImageSequence::run(Functor &callback, unsigned int num_threads)
+    {
+        Private::runParallel<Functor, false>(callback,
+                                             Private::ListAccessor(*this),
+                                             num_threads);
+    }
+
+    template <typename Functor>
+    void ImageSequence::runOrdered(Functor &callback, unsigned int num_threads)
+    {
+        Private::runParallel<Functor, true>(callback,
+                                            Private::ListAccessor(*this),
+                                            num_threads);
+    }
+}
+
+#endif /* IMAGE_SEQUENCE_H_ */
@@ -25,9 +25,30 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define IMAGE_THRESHOLD_H_
 
 #include <odf/image.h>
+#include <odf/trace.h>
+#include <odf/metrics.h>
+#include <odf/private/kernels.h>
 
 namespace ODF
 {
+    /* labels of a pixel, bit k is set if the k-th function accepts it */
+    template <unsigned int arity>
+    inline uchar _thresholdLabel(const cv::Vec<uchar, arity> &, unsigned int)
+    {
+        return 0;
+    }
+
+    template <unsigned int arity, typename Functor, typename... Functors>
+    inline uchar _thresholdLabel(const cv::Vec<uchar, arity> &value,
+                                 unsigned int bit,
+                                 Functor &fn,
+                                 Functors &... fns)
+    {
+        uchar label = fn(value) ? (uchar)(1 << bit) : 0;
+
+        return label | _thresholdLabel<arity>(value, bit + 1, fns...);
+    }
+
     template <unsigned int arity, typename Functor>
     cv::Mat Image::threshold(Functor &fn) const
     {
@@ -150,35 +171,146 @@ namespace ODF
         return this->_threshold<3, Functor>(fn, &mask, convert_to, color);
     }
 
+    template <unsigned int arity, typename... Functors>
+    cv::Mat Image::thresholdLabels(unsigned int convert_to,
+                                   const cv::Mat &mask,
+                                   Functors &... fns) const
+    {
+        static_assert(sizeof...(Functors) >= 1 && sizeof...(Functors) <= 8,
+                      "Label mask has room for one to eight classes");
+
+        std::vector<RegionOfInterest::Span> whole;
+        cv::Vec<uchar, arity> value;
+        const uchar *iptr = NULL; /* image data pointer */
+        const uchar *fptr = NULL; /* input mask data pointer */
+        uchar *lptr = NULL; /* label mask data pointer */
+        uint64_t pixels = 0;
+        uint64_t masked = 0;
+        uchar masked_label = 0;
+        const Kernels &kernels = getKernels();
+        cv::Rect area;
+        cv::Mat image;
+        cv::Mat labels;
+
+        ODF_TRACE("threshold");
+
+        labels = cv::Mat::zeros(this->image.rows, this->image.cols, CV_8U);
+        area = this->_processedArea();
+        if (area.area() == 0) {
+            return labels;
+        }
+
+        image = this->_thresholdGetImage(convert_to, area);
+        if (!mask.empty()) {
+            masked_label = _thresholdLabel<arity>(cv::Vec<uchar, arity>::all(0),
+                                                  0, fns...);
+        }
+        whole.push_back(RegionOfInterest::Span(area.x, area.x + area.width));
+
+        for (int i = 0; i < area.height; i++) {
+            const std::vector<RegionOfInterest::Span> &spans =
+                !this->roi ? whole : this->roi->getSpans(area.y + i);
+
+            iptr = image.ptr<uchar>(i);
+            lptr = labels.ptr<uchar>(area.y + i);
+            fptr = mask.empty() ? NULL : mask.ptr<uchar>(area.y + i);
+
+            for (size_t s = 0; s < spans.size(); s++) {
+                pixels += spans[s].second - spans[s].first;
+                if (fptr != NULL) {
+                    masked += kernels.fillMasked(&fptr[spans[s].first],
+                                                 &lptr[spans[s].first],
+                                                 spans[s].second - spans[s].first,
+                                                 masked_label);
+                }
+
+                for (int m = spans[s].first; m < spans[s].second; m++) {
+                    if (fptr != NULL && fptr[m] == 0) {
+                        continue;
+                    }
+
+                    value = cv::Vec<uchar, arity>(&iptr[(m - area.x) * arity]);
+                    lptr[m] = _thresholdLabel<arity>(value, 0, fns...);
+                }
+            }
+        }
+
+        this->_countThreshold(pixels, masked, !mask.empty(),
+                              sizeof...(Functors));
+
+        return labels;
+    }
+
     template <unsigned int arity, typename Functor>
     cv::Mat Image::_threshold(Functor &threshold_fn,
                               const cv::Mat *input_mask,
                               unsigned int convert_to) const
     {
+        std::vector<RegionOfInterest::Span> whole;
         cv::Vec<uchar, arity> value;
-        uchar *iptr = NULL; /* image data pointer */
+        const uchar *iptr = NULL; /* image data pointer */
+        const uchar *fptr = NULL; /* input mask data pointer */
         uchar *mptr = NULL; /* mask data pointer */
+        uint64_t pixels = 0;
+        uint64_t masked = 0;
+        uchar masked_value;
+        const Kernels &kernels = getKernels();
+        cv::Rect area;
         cv::Mat image;
         cv::Mat mask;
-        bool bret;
 
-        image = this->_thresholdGetImage(input_mask, convert_to);
+        ODF_TRACE("threshold");
+
         mask = cv::Mat::zeros(this->image.rows, this->image.cols, CV_8U);
+        area = this->_processedArea();
+        if (area.area() == 0) {
+            return mask;
+        }
+
+        /* only the region of interest is converted (once per colour
+         * space), masked pixels are not copied but decided by the value
+         * they would be masked to */
+        image = this->_thresholdGetImage(convert_to, area);
+        if (input_mask != NULL && input_mask->empty()) {
+            input_mask = NULL;
+        }
+        masked_value = input_mask != NULL
+                       && threshold_fn(cv::Vec<uchar, arity>::all(0)) ? 255 : 0;
+        whole.push_back(RegionOfInterest::Span(area.x, area.x + area.width));
+
+        for (int i = 0; i < area.height; i++) {
+            const std::vector<RegionOfInterest::Span> &spans =
+                !this->roi ? whole : this->roi->getSpans(area.y + i);
 
-        for (unsigned int i = 0; i < this->image.rows; i++) {
             iptr = image.ptr<uchar>(i);
-            mptr = mask.ptr<uchar>(i);
+            mptr = mask.ptr<uchar>(area.y + i);
+            fptr = input_mask == NULL ? NULL
+                                      : input_mask->ptr<uchar>(area.y + i);
+
+            for (size_t s = 0; s < spans.size(); s++) {
+                pixels += spans[s].second - spans[s].first;
+                if (fptr != NULL) {
+                    masked += kernels.fillMasked(&fptr[spans[s].first],
+                                                 &mptr[spans[s].first],
+                                                 spans[s].second - spans[s].first,
+                                                 masked_value);
+                }
 
-            for (unsigned int j = 0, m = 0;
-                 j < this->image.cols * arity;
-                 j += arity, m++) {
-                value = cv::Vec<uchar, arity>(&iptr[j]);
-                if (threshold_fn(value)) {
-                    mptr[m] = 255;
+                for (int m = spans[s].first; m < spans[s].second; m++) {
+                    if (fptr != NULL && fptr[m] == 0) {
+                        continue;
+                    }
+
+                    value = cv::Vec<uchar, arity>(&iptr[(m - area.x) * arity]);
+                    if (threshold_fn(value)) {
+                        mptr[m] = 255;
+                    }
                 }
             }
         }
 
+        this->_countThreshold(pixels, masked, input_mask != NULL);
+
         return mask;
     }
 
@@ -188,36 +320,76 @@ namespace ODF
                               unsigned int convert_to,
                               const cv::Vec<uchar, arity> &color)
     {
+        std::vector<RegionOfInterest::Span> whole;
         cv::Vec<uchar, arity> value;
         uchar *optr = NULL; /* original data pointer */
-        uchar *iptr = NULL; /* image data pointer */
+        const uchar *iptr = NULL; /* image data pointer */
+        const uchar *fptr = NULL; /* input mask data pointer */
         uchar *mptr = NULL; /* mask data pointer */
+        uint64_t pixels = 0;
+        uint64_t masked = 0;
+        bool masked_result;
+        cv::Rect area;
         cv::Mat image;
         cv::Mat mask;
-        bool bret;
 
-        image = this->_thresholdGetImage(input_mask, convert_to);
+        ODF_TRACE("threshold");
+
         mask = cv::Mat::zeros(this->image.rows, this->image.cols, CV_8U);
+        area = this->_processedArea();
+        if (area.area() == 0) {
+            return mask;
+        }
+
+        /* only the region of interest is converted (once per colour
+         * space), masked pixels are not copied but decided by the value
+         * they would be masked to */
+        image = this->_thresholdGetImage(convert_to, area);
+        if (input_mask != NULL && input_mask->empty()) {
+            input_mask = NULL;
+        }
+        masked_result = input_mask != NULL
+                        && threshold_fn(cv::Vec<uchar, arity>::all(0));
+        whole.push_back(RegionOfInterest::Span(area.x, area.x + area.width));
+
+        for (int i = 0; i < area.height; i++) {
+            const std::vector<RegionOfInterest::Span> &spans =
+                !this->roi ? whole : this->roi->getSpans(area.y + i);
 
-        for (unsigned int i = 0; i < this->image.rows; i++) {
-            optr = this->image.ptr<uchar>(i);
+            optr = this->image.ptr<uchar>(area.y + i);
             iptr = image.ptr<uchar>(i);
-            mptr = mask.ptr<uchar>(i);
+            mptr = mask.ptr<uchar>(area.y + i);
+            fptr = input_mask == NULL ? NULL
+                                      : input_mask->ptr<uchar>(area.y + i);
+
+            for (size_t s = 0; s < spans.size(); s++) {
+                pixels += spans[s].second - spans[s].first;
+                for (int m = spans[s].first; m < spans[s].second; m++) {
+                    if (fptr != NULL && fptr[m] == 0) {
+                        masked++;
+                        if (!masked_result) {
+                            continue;
+                        }
+                    } else {
+                        value = cv::Vec<uchar, arity>(&iptr[(m - area.x) * arity]);
+                        if (!threshold_fn(value)) {
+                            continue;
+                        }
+                    }
 
-            for (unsigned int j = 0, m = 0;
-                 j < this->image.cols * arity;
-                 j += arity, m++) {
-                value = cv::Vec<uchar, arity>(&iptr[j]);
-                if (threshold_fn(value)) {
                     mptr[m] = 255;
-
                     for (unsigned int a = 0; a < arity; a++) {
-                        optr[j + a] = color[a];
+                        optr[m * arity + a] = color[a];
                     }
                 }
             }
         }
 
+        this->_countThreshold(pixels, masked, input_mask != NULL);
+
+        /* painted pixels make the converted images stale */
+        this->invalidateConversions();
+
         return mask;
     }
 }
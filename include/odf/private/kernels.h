@@ -0,0 +1,98 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_KERNELS_H_
+#define ODF_KERNELS_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <odf/cpu.h>
+
+namespace ODF
+{
+    /**
+     * Table of hot loops compiled for one instruction set level. All
+     * variants give bit exact results.
+     */
+    struct Kernels
+    {
+        CPU::Level level;
+
+        /**
+         * Threshold: set 'out[i]' to 'value' where 'mask[i]' is zero.
+         *
+         * @return Number of such pixels.
+         */
+        size_t (*fillMasked)(const unsigned char *mask, unsigned char *out,
+                             size_t count, unsigned char value);
+
+        /**
+         * SAT: compute row of summed area table from 'above' row and mask
+         * row with values 0 and 255. Rows of the table have 'cols' + 1
+         * items and the first one is always zero.
+         */
+        void (*integralRow)(const unsigned char *mask, const int *above,
+                            int *out, int cols);
+
+        /**
+         * Scan: fill ratios in % of 'area' of 'count' windows 'width'
+         * columns wide, the k-th starts at column 'x' + k * 'step' and
+         * spans summed area table rows 'top' and 'bottom'.
+         */
+        void (*windowRatios)(const int *top, const int *bottom, int x,
+                             int width, int step, int count,
+                             unsigned int area, double *ratios);
+
+        /**
+         * Box intersection: index of the first of 'count' rectangles that
+         * intersects 'rect' (x, y, width, height), or 'count' if none.
+         * Rectangles are stored as four ints, 'stride' ints apart.
+         */
+        size_t (*firstIntersect)(const int *rects, size_t stride,
+                                 size_t count, const int *rect);
+
+        /**
+         * Classifier: for each of 'count' three channel pixels AND the
+         * rule masks of three 256 entry 'tables', drop 'pairs' of failed
+         * comparisons (see BitsetClassifier) and write 'fallback' (0 or
+         * 255) inverted if the first rule left is in 'decisive'.
+         */
+        void (*classifyRow)(const unsigned char *pixels, unsigned char *out,
+                            size_t count, const uint32_t *tables,
+                            const uint32_t *pairs, uint32_t decisive,
+                            unsigned char fallback);
+    };
+
+    /**
+     * @return Kernels selected for this processor.
+     */
+    const Kernels & getKernels();
+
+    /* one table per level, only those enabled in the build exist */
+    extern const Kernels kernels_generic;
+    extern const Kernels kernels_sse4;
+    extern const Kernels kernels_avx2;
+    extern const Kernels kernels_avx512;
+}
+
+#endif /* ODF_KERNELS_H_ */
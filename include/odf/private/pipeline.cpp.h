@@ -0,0 +1,294 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <map>
+#include <chrono>
+#include <stdexcept>
+#include <odf/pipeline.h>
+
+namespace ODF
+{
+    namespace Private
+    {
+        inline uint64_t elapsedNs(std::chrono::steady_clock::time_point since)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - since).count();
+        }
+    }
+
+    template <typename T>
+    Pipeline<T>::Pipeline(size_t queue_capacity)
+        : stages(),
+          queue_capacity(queue_capacity),
+          next_seq(0),
+          running(false),
+          aborted(false),
+          error()
+    {
+        /* noop */
+    }
+
+    template <typename T>
+    Pipeline<T>::~Pipeline()
+    {
+        if (!this->running) {
+            return;
+        }
+
+        try {
+            this->finish();
+        } catch (...) {
+            /* errors are reported only from explicit finish() */
+        }
+    }
+
+    template <typename T>
+    void Pipeline<T>::addStage(const std::string &name,
+                               PipelineStage<T> *stage,
+                               unsigned int num_threads /*= 1*/,
+                               bool ordered /*= false*/)
+    {
+        Stage *s;
+
+        if (this->running) {
+            throw std::logic_error("Pipeline is already running");
+        }
+
+        s = new Stage();
+        s->name = name;
+        s->stage = stage;
+        s->num_threads = (ordered || num_threads == 0) ? 1 : num_threads;
+        s->ordered = ordered;
+        s->input.reset(new Queue(this->queue_capacity));
+        s->active = 0;
+        s->items = 0;
+        s->dropped = 0;
+        s->busy_ns = 0;
+        s->starved_ns = 0;
+        s->blocked_ns = 0;
+
+        this->stages.push_back(std::unique_ptr<Stage>(s));
+    }
+
+    template <typename T>
+    void Pipeline<T>::start()
+    {
+        if (this->running) {
+            throw std::logic_error("Pipeline is already running");
+        }
+
+        if (this->stages.empty()) {
+            throw std::logic_error("Pipeline has no stages");
+        }
+
+        this->running = true;
+
+        for (size_t i = 0; i < this->stages.size(); i++) {
+            Stage *stage = this->stages[i].get();
+
+            stage->active = stage->num_threads;
+            for (unsigned int t = 0; t < stage->num_threads; t++) {
+                stage->threads.push_back(std::thread(&Pipeline<T>::worker,
+                                                     this, i));
+            }
+        }
+    }
+
+    template <typename T>
+    bool Pipeline<T>::push(const T &item)
+    {
+        Envelope envelope;
+
+        if (!this->running) {
+            throw std::logic_error("Pipeline is not running");
+        }
+
+        envelope.seq = this->next_seq++;
+        envelope.item = item;
+
+        return this->stages.front()->input->push(envelope);
+    }
+
+    template <typename T>
+    void Pipeline<T>::finish()
+    {
+        std::exception_ptr ex;
+
+        if (!this->running) {
+            return;
+        }
+
+        /* each stage closes the next queue when its last thread quits */
+        this->stages.front()->input->close();
+
+        for (size_t i = 0; i < this->stages.size(); i++) {
+            std::vector<std::thread> &threads = this->stages[i]->threads;
+
+            for (size_t t = 0; t < threads.size(); t++) {
+                threads[t].join();
+            }
+
+            threads.clear();
+        }
+
+        this->running = false;
+
+        {
+            std::lock_guard<std::mutex> lock(this->error_mutex);
+            ex = this->error;
+            this->error = std::exception_ptr();
+        }
+
+        if (ex) {
+            std::rethrow_exception(ex);
+        }
+    }
+
+    template <typename T>
+    std::vector<typename Pipeline<T>::Statistics>
+    Pipeline<T>::getStatistics() const
+    {
+        std::vector<Statistics> result;
+        Statistics stats;
+
+        for (size_t i = 0; i < this->stages.size(); i++) {
+            const Stage *stage = this->stages[i].get();
+
+            stats.name = stage->name;
+            stats.num_threads = stage->num_threads;
+            stats.ordered = stage->ordered;
+            stats.items = stage->items;
+            stats.dropped = stage->dropped;
+            stats.busy_ms = stage->busy_ns / 1e6;
+            stats.starved_ms = stage->starved_ns / 1e6;
+            stats.blocked_ms = stage->blocked_ns / 1e6;
+
+            result.push_back(stats);
+        }
+
+        return result;
+    }
+
+    template <typename T>
+    void Pipeline<T>::worker(size_t index)
+    {
+        Stage *stage = this->stages[index].get();
+        Queue *output = NULL;
+        std::map<uint64_t, Envelope> pending; /* reorder buffer */
+        typename std::map<uint64_t, Envelope>::iterator it;
+        std::chrono::steady_clock::time_point start;
+        uint64_t expected = 0;
+        Envelope envelope;
+        bool bret;
+
+        if (index + 1 < this->stages.size()) {
+            output = this->stages[index + 1]->input.get();
+        }
+
+        try {
+            while (!this->aborted) {
+                start = std::chrono::steady_clock::now();
+                bret = stage->input->pop(envelope);
+                stage->starved_ns += Private::elapsedNs(start);
+                if (!bret) {
+                    break;
+                }
+
+                if (!stage->ordered) {
+                    this->handle(stage, output, envelope);
+                    continue;
+                }
+
+                pending[envelope.seq] = envelope;
+                while (!this->aborted
+                        && (it = pending.find(expected)) != pending.end()) {
+                    this->handle(stage, output, it->second);
+                    pending.erase(it);
+                    expected++;
+                }
+            }
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(this->error_mutex);
+
+                if (!this->error) {
+                    this->error = std::current_exception();
+                }
+            }
+
+            this->abort();
+        }
+
+        /* last thread of the stage tells the next stage there is no more
+         * input */
+        if (--stage->active == 0 && output != NULL) {
+            output->close();
+        }
+    }
+
+    template <typename T>
+    void Pipeline<T>::handle(Stage *stage, Queue *output, Envelope &envelope)
+    {
+        std::chrono::steady_clock::time_point start;
+        bool bret;
+
+        if (!envelope.dropped) {
+            start = std::chrono::steady_clock::now();
+            bret = stage->stage->process(envelope.item);
+            stage->busy_ns += Private::elapsedNs(start);
+            stage->items++;
+
+            if (!bret) {
+                /* keep passing the sequence number so ordered stages do
+                 * not wait for it */
+                envelope.dropped = true;
+                envelope.item = T();
+                stage->dropped++;
+            }
+        }
+
+        if (output == NULL) {
+            return;
+        }
+
+        start = std::chrono::steady_clock::now();
+        output->push(envelope);
+        stage->blocked_ns += Private::elapsedNs(start);
+    }
+
+    template <typename T>
+    void Pipeline<T>::abort()
+    {
+        this->aborted = true;
+
+        for (size_t i = 0; i < this->stages.size(); i++) {
+            this->stages[i]->input->close();
+        }
+    }
+}
+
+#endif /* PIPELINE_H_ */
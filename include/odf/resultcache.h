@@ -0,0 +1,164 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_RESULTCACHE_H_
+#define ODF_RESULTCACHE_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+#include <odf/boundingbox.h>
+
+namespace ODF
+{
+    /**
+     * Cache of detection results keyed by frame content.
+     *
+     * The key consists of a hash of the input (decoded pixels, file bytes
+     * or anything else that determines the result) and a hash of the
+     * processing parameters. Results are kept in memory with least
+     * recently used eviction and optionally also in a directory, so they
+     * survive between runs.
+     *
+     * It is safe to use the cache from multiple threads.
+     */
+    class ResultCache
+    {
+    public:
+        struct Statistics
+        {
+            unsigned long hits;
+            unsigned long disk_hits;
+            unsigned long misses;
+            unsigned long evictions;
+            unsigned long write_failures;
+        };
+
+        /**
+         * Create a new cache.
+         *
+         * @param[in] capacity Number of results kept in memory.
+         * @param[in] directory Directory of the on-disk store, empty string
+         *                      disables it. The directory must exist.
+         */
+        ResultCache(size_t capacity, const std::string &directory = "");
+
+        /**
+         * Find result of a frame.
+         *
+         * @param[in] content Hash of the frame content.
+         * @param[in] params Hash of the processing parameters.
+         * @param[out] mask Stored mask, may be NULL.
+         * @param[out] objects Stored objects, may be NULL.
+         *
+         * @return True on hit.
+         */
+        bool lookup(uint64_t content, uint64_t params,
+                    cv::Mat *mask, BoundingBoxVector *objects);
+
+        /**
+         * Store result of a frame. The mask is not copied, the caller must
+         * not modify it afterwards.
+         *
+         * The entry is written to the on-disk store outside of the cache
+         * lock. Failed writes are only counted in the statistics, the
+         * result is still cached in memory.
+         */
+        void store(uint64_t content, uint64_t params,
+                   const cv::Mat &mask, const BoundingBoxVector &objects);
+
+        /**
+         * @return Cache statistics.
+         */
+        Statistics getStatistics() const;
+
+        /**
+         * Hash of 'length' bytes, 'seed' allows to chain several buffers.
+         */
+        static uint64_t hash(const void *data, size_t length,
+                             uint64_t seed = 0);
+
+        /**
+         * Hash of matrix dimensions, type and pixels.
+         */
+        static uint64_t hash(const cv::Mat &matrix, uint64_t seed = 0);
+
+        /**
+         * Hash of a string, e.g. serialized parameters.
+         */
+        static uint64_t hash(const std::string &value, uint64_t seed = 0);
+
+        /**
+         * Hash of file content, to be used before the file is decoded.
+         *
+         * @throws runtime_error if the file can not be read.
+         */
+        static uint64_t hashFile(const std::string &filename);
+
+    private:
+        struct Key
+        {
+            uint64_t content;
+            uint64_t params;
+
+            bool operator==(const Key &other) const;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key &key) const;
+        };
+
+        struct Entry
+        {
+            Key key;
+            cv::Mat mask;
+            BoundingBoxVector objects;
+        };
+
+        typedef std::list<Entry> EntryList;
+        typedef std::unordered_map<Key, EntryList::iterator, KeyHash> EntryMap;
+
+        size_t capacity;
+        std::string directory;
+        EntryList entries; /* most recently used first */
+        EntryMap map;
+        Statistics stats;
+        mutable std::mutex mutex;
+        std::atomic<unsigned long> written; /* unique temporary files */
+
+        ResultCache(const ResultCache &);
+        ResultCache & operator=(const ResultCache &);
+
+        void insert(const Entry &entry);
+        std::string entryFilename(const Key &key) const;
+        bool readEntry(const Key &key, Entry *entry) const;
+        bool writeEntry(const Entry &entry);
+    };
+}
+
+#endif /* ODF_RESULTCACHE_H_ */
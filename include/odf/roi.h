@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_ROI_H_
+#define ODF_ROI_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <string>
+#include <utility>
+
+namespace ODF
+{
+    /**
+     * Static region of interest of a camera, e.g. everything except walls,
+     * ceiling and timestamp overlay.
+     *
+     * The region is stored as a mask together with its bounding rectangle
+     * and horizontal spans of each row, so the processing stages can skip
+     * pixels outside of the region without testing them one by one.
+     */
+    class RegionOfInterest
+    {
+    public:
+        /* [start, end) columns of a row that are inside the region */
+        typedef std::pair<int, int> Span;
+
+        /**
+         * Create region from a mask, non-zero pixels are inside.
+         *
+         * @throws logic_error if the mask is not in CV_8U format.
+         */
+        RegionOfInterest(const cv::Mat &mask);
+
+        /**
+         * Create region as union of rectangles.
+         *
+         * @param[in] rects Rectangles.
+         * @param[in] size Image size.
+         */
+        RegionOfInterest(const std::vector<cv::Rect> &rects,
+                         const cv::Size &size);
+
+        /**
+         * Create region as union of polygons.
+         *
+         * @param[in] polygons Polygons.
+         * @param[in] size Image size.
+         */
+        RegionOfInterest(const std::vector<std::vector<cv::Point> > &polygons,
+                         const cv::Size &size);
+
+        /**
+         * Load region from a file. Image files (png, bmp, pgm, jpg, tif)
+         * are used as a mask. Otherwise the file is a text file where each
+         * line is one of:
+         *
+         *   rect x y width height
+         *   polygon x1 y1 x2 y2 x3 y3 ...
+         *
+         * Empty lines and lines starting with # are ignored.
+         *
+         * @param[in] filename Region file.
+         * @param[in] size Image size.
+         *
+         * @throws runtime_error if the file can not be read or parsed.
+         */
+        static RegionOfInterest load(const std::string &filename,
+                                     const cv::Size &size);
+
+        /**
+         * @return Image size.
+         */
+        cv::Size getSize() const;
+
+        /**
+         * @return Smallest rectangle that contains the whole region.
+         */
+        const cv::Rect & getBoundingRect() const;
+
+        /**
+         * @return Mask with 255 inside the region.
+         */
+        const cv::Mat & getMask() const;
+
+        /**
+         * @return Spans of 'row' that are inside the region, in image
+         *         coordinates.
+         */
+        const std::vector<Span> & getSpans(int row) const;
+
+        /**
+         * @return True if at least one pixel of 'rect' is inside the region.
+         */
+        bool intersects(const cv::Rect &rect) const;
+
+        /**
+         * @return Number of pixels inside the region.
+         */
+        unsigned int area() const;
+
+    private:
+        cv::Mat mask;
+        cv::Mat sat;
+        cv::Rect bounding_rect;
+        std::vector<std::vector<Span> > spans;
+
+        void build();
+    };
+}
+
+#endif /* ODF_ROI_H_ */
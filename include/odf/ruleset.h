@@ -0,0 +1,425 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_RULESET_H_
+#define ODF_RULESET_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <string>
+#include <istream>
+#include <utility>
+#include <stdint.h>
+
+namespace ODF
+{
+    class RuleProfile;
+
+    /**
+     * Colour rule: a pixel matches if each of its channels is in the
+     * allowed ranges of that channel and all cross channel comparisons
+     * hold. Channels are indices into cv::Vec3b, e.g. HUE, SAT and VAL.
+     *
+     * Each channel is stored as a 256 bit set of allowed values, so a
+     * test costs the same no matter how many ranges it has.
+     */
+    class ColorRule
+    {
+    public:
+        /**
+         * Create a rule that matches all pixels.
+         *
+         * @param[in] accept Result of a matching pixel.
+         * @param[in] name Rule name, used in reports.
+         */
+        ColorRule(bool accept = true, const std::string &name = "");
+
+        /**
+         * Allow values from 'min' to 'max' in 'channel'. The first range
+         * restricts the channel, next ranges extend it. Bounds are rounded
+         * outwards to whole values, so ODF_CONV_* values can be used.
+         *
+         * @throws logic_error if 'channel' is not 0, 1 or 2.
+         */
+        ColorRule & range(unsigned int channel, double min, double max);
+
+        /**
+         * Allow values from 'min' up in 'channel'.
+         *
+         * @throws logic_error if 'channel' is not 0, 1 or 2.
+         */
+        ColorRule & atLeast(unsigned int channel, double min);
+
+        /**
+         * Require value of 'channel' to be greater than value of 'other'.
+         *
+         * @throws logic_error if a channel is not 0, 1 or 2.
+         */
+        ColorRule & greater(unsigned int channel, unsigned int other);
+
+        /**
+         * @return True if 'value' matches the rule.
+         */
+        bool matches(const cv::Vec3b &value) const
+        {
+            for (unsigned int k = 0; k < this->num_tests; k++) {
+                if (!this->allows(this->order[k], value[this->order[k]])) {
+                    return false;
+                }
+            }
+
+            for (size_t k = 0; k < this->comparisons.size(); k++) {
+                if (value[this->comparisons[k].first]
+                        <= value[this->comparisons[k].second]) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @return True if 'value' is allowed in 'channel'.
+         */
+        bool allows(unsigned int channel, uchar value) const
+        {
+            return (this->bits[channel][value >> 6] >> (value & 63)) & 1;
+        }
+
+        /**
+         * @return True if some pixel may match both rules. Cross channel
+         *         comparisons are not considered.
+         */
+        bool overlaps(const ColorRule &other) const;
+
+        /**
+         * @return True if 'channel' is restricted by a range.
+         */
+        bool isRestricted(unsigned int channel) const;
+
+        /**
+         * @return Cross channel comparisons, (a, b) means a > b.
+         */
+        const std::vector<std::pair<unsigned int, unsigned int> > &
+        getComparisons() const;
+
+        /**
+         * @return Result of a matching pixel.
+         */
+        bool accepts() const;
+
+        /**
+         * @return Rule name.
+         */
+        const std::string & getName() const;
+
+    private:
+        friend class RuleSet;
+
+        uint64_t bits[3][4];
+        bool restricted[3];
+        std::vector<std::pair<unsigned int, unsigned int> > comparisons;
+        unsigned int order[3]; /* restricted channels in test order */
+        unsigned int num_tests;
+        bool accept;
+        std::string name;
+    };
+
+    /**
+     * Ordered list of colour rules usable as a threshold function. The
+     * first rule that matches a pixel decides, pixels matched by no rule
+     * get the fallback result.
+     *
+     * Before the rules, each channel is tested against the union of rules
+     * whose result differs from the fallback. Most pixels of a frame are
+     * usually decided by these few tests.
+     */
+    class RuleSet
+    {
+    public:
+        /**
+         * Create an empty rule set.
+         *
+         * @param[in] fallback Result of pixels no rule matches.
+         * @param[in] conversion cv::COLOR_*2* value giving the colour space
+         *                       of the rules, COLOR_COLORCVT_MAX means the
+         *                       image is used as is.
+         */
+        RuleSet(bool fallback = false,
+                unsigned int conversion = cv::COLOR_COLORCVT_MAX);
+
+        /**
+         * Load rule set from a text file. Each line is one of:
+         *
+         *   space hsv|ycrcb|rgb
+         *   fallback accept|reject
+         *   accept|reject name test ...
+         *
+         * A test is a channel name followed by one or more 'min max'
+         * ranges, or a comparison of two channels such as 'val>sat'. HSV
+         * channels are hue (0-360°), sat and val (0-100%), converted by
+         * ODF_CONV_*. YCrCb channels y, cr, cb and RGB channels red, green,
+         * blue are 0-255. The space (rgb by default) must precede the rules
+         * and sets the conversion. Empty lines and lines starting with #
+         * are ignored.
+         *
+         * @param[in] filename Rule file.
+         *
+         * @throws runtime_error if the file can not be read or parsed.
+         */
+        static RuleSet load(const std::string &filename);
+
+        /**
+         * Parse rule set in the load() format from 'in'.
+         *
+         * @param[in] in Rules.
+         * @param[in] name Source of the rules used in error messages.
+         *
+         * @throws runtime_error if the rules can not be parsed.
+         */
+        static RuleSet parse(std::istream &in, const std::string &name);
+
+        /**
+         * Append 'rule', it is tested after all previous rules.
+         */
+        RuleSet & add(const ColorRule &rule);
+
+        /**
+         * @return Number of rules.
+         */
+        size_t size() const;
+
+        /**
+         * @return Rule at position 'index'.
+         */
+        const ColorRule & operator[](size_t index) const;
+
+        /**
+         * @return Result of pixels no rule matches.
+         */
+        bool getFallback() const;
+
+        /**
+         * @return cv::COLOR_*2* value to pass to Image methods.
+         */
+        unsigned int getConversion() const;
+
+        /**
+         * Threshold function.
+         *
+         * @return Result of the first rule matching 'value'.
+         */
+        bool operator()(const cv::Vec3b &value) const
+        {
+            for (unsigned int k = 0; k < this->num_checks; k++) {
+                const unsigned int c = this->checks[k];
+
+                if (!((this->reachable[c][value[c] >> 6]
+                        >> (value[c] & 63)) & 1)) {
+                    return this->fallback;
+                }
+            }
+
+            for (size_t i = 0; i < this->rules.size(); i++) {
+                if (this->rules[i].matches(value)) {
+                    return this->rules[i].accept;
+                }
+            }
+
+            return this->fallback;
+        }
+
+        /**
+         * @return Number of tests operator() performs for 'value'.
+         */
+        unsigned int countTests(const cv::Vec3b &value) const;
+
+        /**
+         * Create rule set that gives the same result for every pixel, but
+         * is ordered to be cheap on pixels like those in 'profile'.
+         *
+         * Rules are sorted by match rate and cost, but a rule never moves
+         * over an overlapping rule with a different result. Tests inside
+         * each rule and the union tests are sorted by reject rate. Rules
+         * with the fallback result that precede no overlapping rule with
+         * a different result are dropped.
+         *
+         * @param[in] profile Profile collected on this rule set.
+         *
+         * @throws logic_error if the profile does not belong to this rule
+         *         set.
+         */
+        RuleSet optimize(const RuleProfile &profile) const;
+
+    private:
+        friend class RuleProfile;
+
+        std::vector<ColorRule> rules;
+        bool fallback;
+        unsigned int conversion;
+
+        /* union of rules whose result differs from fallback */
+        uint64_t reachable[3][4];
+        unsigned int checks[3];
+        unsigned int num_checks;
+
+        bool reaches(unsigned int channel, uchar value) const;
+        void build(const unsigned int *order);
+    };
+
+    /**
+     * Rates of rule tests on sample pixels, collected to optimize a rule
+     * set. Profiles of the same rule set, e.g. from several threads, can
+     * be added together.
+     */
+    class RuleProfile
+    {
+    public:
+        /**
+         * Create an empty profile of 'rules'.
+         */
+        RuleProfile(const RuleSet &rules);
+
+        /**
+         * Evaluate all tests of all rules on 'value'.
+         */
+        void sample(const cv::Vec3b &value);
+
+        /**
+         * Sample each 'step'-th pixel of 'image' where 'mask' is not zero.
+         *
+         * @param[in] image Image in the colour space of the rules (CV_8UC3).
+         * @param[in] mask Image mask, empty mask means no mask.
+         * @param[in] step Sampling step.
+         *
+         * @throws logic_error if the image is not in CV_8UC3 format.
+         */
+        void sample(const cv::Mat &image, const cv::Mat &mask = cv::Mat(),
+                    unsigned int step = 1);
+
+        /**
+         * Add samples of 'other' profile of the same rule set.
+         *
+         * @throws logic_error if the profiles belong to different rule sets.
+         */
+        RuleProfile & operator+=(const RuleProfile &other);
+
+        /**
+         * @return Number of sampled pixels.
+         */
+        uint64_t getSamples() const;
+
+        /**
+         * @return Average number of tests the profiled rule set performs
+         *         per pixel.
+         */
+        double getTestsPerPixel() const;
+
+        /**
+         * @return Part of samples rejected by the union test of 'channel'.
+         */
+        double getCheckRejectRate(unsigned int channel) const;
+
+        /**
+         * @return Part of samples that passed union tests and match 'rule'.
+         */
+        double getMatchRate(size_t rule) const;
+
+        /**
+         * @return Part of samples that passed union tests and are rejected
+         *         by 'channel' test of 'rule'.
+         */
+        double getRejectRate(size_t rule, unsigned int channel) const;
+
+    private:
+        friend class RuleSet;
+
+        RuleSet rules;
+        uint64_t samples;
+        uint64_t passed;
+        uint64_t tests;
+        uint64_t check_rejects[3];
+        std::vector<uint64_t> matches;
+        std::vector<uint64_t> rejects; /* three per rule */
+    };
+
+    /**
+     * Rule set that profiles itself on the first pixels it is asked about
+     * and then switches to the optimized order. Results are always the
+     * same as of the original rule set.
+     *
+     * The object is not thread safe, use one per thread. Functors passed
+     * to ImageSequence::run() are copied per thread automatically.
+     */
+    class AdaptiveRuleSet
+    {
+    public:
+        /**
+         * @param[in] rules Rule set.
+         * @param[in] samples Number of samples before optimization.
+         * @param[in] step Sample each 'step'-th pixel.
+         */
+        AdaptiveRuleSet(const RuleSet &rules, uint64_t samples = 100000,
+                        unsigned int step = 16);
+
+        /**
+         * Threshold function.
+         */
+        bool operator()(const cv::Vec3b &value)
+        {
+            if (this->learning && this->counter++ % this->step == 0) {
+                this->learn(value);
+            }
+
+            return this->current(value);
+        }
+
+        /**
+         * @return True until the rule set is optimized.
+         */
+        bool isLearning() const;
+
+        /**
+         * @return Rule set in current order.
+         */
+        const RuleSet & getRules() const;
+
+        /**
+         * @return Profile of the original rule set.
+         */
+        const RuleProfile & getProfile() const;
+
+    private:
+        RuleSet original;
+        RuleSet current;
+        RuleProfile profile;
+        uint64_t limit;
+        unsigned int step;
+        uint64_t counter;
+        bool learning;
+
+        void learn(const cv::Vec3b &value);
+    };
+}
+
+#endif /* ODF_RULESET_H_ */
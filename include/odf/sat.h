@@ -48,7 +48,7 @@ namespace ODF
          *
          * @throws logic_error if the mask is not in CV_8U format.
          */
-        SAT(const cv::Mat &mask) throw (std::logic_error);
+        SAT(const cv::Mat &mask);
 
         /**
          * Computes how many pixels of the rectangle area is covered by
@@ -71,6 +71,24 @@ namespace ODF
          * @return Filled ratio in %.
          */
         double fillRatio(const cv::Rect &rect, unsigned int area) const;
+
+        /**
+         * Computes fill ratios of 'count' windows between rows 'top' and
+         * 'bottom' that are 'width' columns wide. The k-th window starts
+         * at column 'x' + k * 'step'. All windows must lie inside the
+         * mask. The results are the same as of fillRatio().
+         *
+         * @param[in] top Top row of the windows.
+         * @param[in] bottom Bottom row of the windows (exclusive).
+         * @param[in] x Left column of the first window.
+         * @param[in] width Window width.
+         * @param[in] step Horizontal distance of windows.
+         * @param[in] count Number of windows.
+         * @param[in] area Referenced area size.
+         * @param[out] ratios Filled ratios in %, 'count' items.
+         */
+        void fillRatios(int top, int bottom, int x, int width, int step,
+                        int count, unsigned int area, double *ratios) const;
     };
 }
 
@@ -0,0 +1,230 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_SHMFRAMERING_H_
+#define ODF_SHMFRAMERING_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <stdexcept>
+#include <stdint.h>
+#include <odf/image.h>
+#include <odf/framesource.h>
+
+/**
+ * Space reserved for each frame name in the ring [bytes].
+ */
+#define ODF_SHMRING_NAME_SIZE 256
+
+namespace ODF
+{
+    /**
+     * Ring of frames in POSIX shared memory.
+     *
+     * One process (producer) writes frames into the ring, any number of
+     * local processes (consumers) read them. Frames are never copied: the
+     * producer can capture directly into the slot returned by
+     * ShmFrameRing::beginWrite() and consumers get images that point into
+     * the shared memory. Synchronization uses only atomic operations in
+     * the shared memory, there is no system call per frame. Only an idle
+     * consumer sleeps on a futex, which the producer wakes on the next
+     * frame.
+     *
+     * The producer never waits for consumers. A consumer that is slower
+     * than the producer loses frames; use ShmFrameRing::isValid() to check
+     * that a frame was not overwritten while it was being processed.
+     */
+    class ShmFrameRing
+    {
+    private:
+        struct Header;
+        struct Slot;
+
+        std::string name;
+        bool owner;
+        uchar *map;
+        size_t map_size;
+        Header *header;
+        uint64_t writing;
+
+        ShmFrameRing(const ShmFrameRing &);
+        ShmFrameRing & operator=(const ShmFrameRing &);
+
+    public:
+        /**
+         * Create a new ring (producer side).
+         *
+         * @param[in] name Shared memory object name, e.g. "/odf-camera0".
+         * @param[in] capacity Number of frames in the ring.
+         * @param[in] rows Number of rows of each frame.
+         * @param[in] cols Number of columns of each frame.
+         * @param[in] type Matrix type of each frame, e.g. CV_8UC3.
+         * @param[in] replace Remove an existing ring with the same name,
+         *                    e.g. one left behind by a crashed producer.
+         *                    Consumers attached to it keep the old ring.
+         *
+         * @throws runtime_error if the shared memory can not be created,
+         *                       also if the ring exists and 'replace' is
+         *                       false.
+         */
+        ShmFrameRing(const std::string &name,
+                     unsigned int capacity,
+                     int rows, int cols, int type,
+                     bool replace = false);
+
+        /**
+         * Attach to an existing ring (consumer side).
+         *
+         * @param[in] name Shared memory object name.
+         *
+         * @throws runtime_error if the ring does not exist or is invalid.
+         */
+        ShmFrameRing(const std::string &name);
+
+        /**
+         * Detach from the ring. The producer also removes the shared
+         * memory object; attached consumers keep their mapping.
+         */
+        ~ShmFrameRing();
+
+        /**
+         * Producer: get image that wraps the next free slot. Fill it and
+         * call ShmFrameRing::commit() to publish it.
+         *
+         * @param[in] filename File name associated with the frame.
+         *
+         * @throws logic_error if called by a consumer.
+         */
+        Image beginWrite(const std::string &filename);
+
+        /**
+         * Producer: publish frame obtained by ShmFrameRing::beginWrite().
+         *
+         * @throws logic_error if there is no frame being written.
+         */
+        void commit();
+
+        /**
+         * Producer: copy 'frame' into the ring and publish it.
+         *
+         * @throws logic_error if 'frame' does not match ring dimensions.
+         */
+        void write(const std::string &filename, const cv::Mat &frame);
+
+        /**
+         * Producer: tell consumers that no more frames will be written.
+         */
+        void close();
+
+        /**
+         * @return True if the producer closed the ring.
+         */
+        bool isClosed() const;
+
+        /**
+         * @return Number of frames published so far.
+         */
+        uint64_t published() const;
+
+        /**
+         * @return Number of frames in the ring.
+         */
+        unsigned int capacity() const;
+
+        /**
+         * Consumer: claim a frame for this consumer. Frames are handed out
+         * only once across all consumers that use this method, which
+         * distributes the frames among workers.
+         *
+         * @return Number of the claimed frame.
+         */
+        uint64_t claim();
+
+        /**
+         * Consumer: get image that points to frame 'index'.
+         *
+         * @param[in] index Frame number.
+         * @param[out] image Frame.
+         *
+         * @return False if the frame was not published yet or it was
+         *         already overwritten.
+         */
+        bool read(uint64_t index, std::unique_ptr<Image> &image) const;
+
+        /**
+         * Consumer: check that frame 'index' is still in the ring. Call it
+         * after processing the frame to make sure the data were not
+         * overwritten meanwhile.
+         */
+        bool isValid(uint64_t index) const;
+
+        /**
+         * Consumer: sleep until frame 'index' is published or the ring is
+         * closed. It may also return early, check again after it.
+         */
+        void wait(uint64_t index) const;
+
+    private:
+        static bool isValid(const Header *header, size_t size);
+        void wake();
+        Slot *slot(uint64_t index) const;
+        uchar *slotData(uint64_t index) const;
+    };
+
+    /**
+     * Frames read from ODF::ShmFrameRing. The frames are not copied.
+     *
+     * In shared mode, all sources attached to the ring split the frames
+     * among themselves. Otherwise each source reads every frame. Frames
+     * that were overwritten before the source got to them are skipped.
+     */
+    class ShmFrameRingSource : public FrameSource
+    {
+    private:
+        ShmFrameRing *ring;
+        bool shared;
+        uint64_t index;
+        std::unique_ptr<Image> current;
+
+    public:
+        ShmFrameRingSource(ShmFrameRing &ring, bool shared);
+
+        /**
+         * Wait for the next frame.
+         *
+         * @return Next frame or NULL if the ring was closed and there are
+         *         no more frames.
+         */
+        Image *next();
+
+        /**
+         * @return True if the frame returned by the last call of
+         *         ShmFrameRingSource::next() was not overwritten yet.
+         */
+        bool isCurrentValid() const;
+    };
+}
+
+#endif /* ODF_SHMFRAMERING_H_ */
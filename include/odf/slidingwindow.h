@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <opencv2/opencv.hpp>
 #include <odf/boundingbox.h>
+#include <odf/roi.h>
 
 namespace ODF
 {
@@ -90,6 +91,25 @@ namespace ODF
         BoundingBoxVector run(const cv::Mat &mask,
                               double threshold,
                               const cv::Rect &tile) const;
+
+        /**
+         * Move sliding window over the region 'roi' in the 'mask'. Only
+         * the bounding rectangle of the region is searched and windows
+         * that lie completely outside of the region are skipped.
+         *
+         * @param[in] mask 8-bit image which contains only values 0 and 255.
+         * @param[in] threshold Threshold for object detection.
+         * @param[in] roi Region that is searched at.
+         */
+        BoundingBoxVector run(const cv::Mat &mask,
+                              double threshold,
+                              const RegionOfInterest &roi) const;
+
+    private:
+        BoundingBoxVector _run(const cv::Mat &mask,
+                               double threshold,
+                               cv::Rect tile,
+                               const RegionOfInterest *roi) const;
     };
 }
 
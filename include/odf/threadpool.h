@@ -0,0 +1,96 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_THREADPOOL_H_
+#define ODF_THREADPOOL_H_
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace ODF
+{
+    class ThreadPool
+    {
+    public:
+        typedef std::function<void ()> Task;
+
+        /**
+         * Create a new thread pool with 'num_threads' worker threads.
+         *
+         * @param[in] num_threads Number of threads (0 means one thread per
+         *                        available CPU core).
+         */
+        ThreadPool(unsigned int num_threads);
+
+        /**
+         * Wait until all submitted tasks are finished and stop the threads.
+         */
+        ~ThreadPool();
+
+        /**
+         * Queue a new task. The task is executed by the first idle worker.
+         *
+         * @param[in] task Task to be executed.
+         */
+        void submit(const Task &task);
+
+        /**
+         * Block until all submitted tasks are finished.
+         *
+         * @throws the first exception that escaped from a task, if any.
+         */
+        void wait();
+
+        /**
+         * @return Number of worker threads.
+         */
+        unsigned int size() const;
+
+        /**
+         * @return Number of available CPU cores, at least 1.
+         */
+        static unsigned int defaultSize();
+
+    private:
+        std::vector<std::thread> threads;
+        std::queue<Task> tasks;
+        std::mutex mutex;
+        std::condition_variable task_available;
+        std::condition_variable tasks_done;
+        std::exception_ptr error;
+        unsigned int pending;
+        bool stopping;
+
+        ThreadPool(const ThreadPool &);
+        ThreadPool & operator=(const ThreadPool &);
+
+        void worker();
+    };
+}
+
+#endif /* ODF_THREADPOOL_H_ */
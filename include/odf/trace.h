@@ -0,0 +1,165 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ODF_TRACE_H_
+#define ODF_TRACE_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <atomic>
+#include <stdint.h>
+
+namespace ODF
+{
+    /**
+     * Per-stage timing instrumentation.
+     *
+     * Library stages are wrapped in ODF_TRACE scopes. When tracing is
+     * disabled (the default) a scope costs a single relaxed atomic load.
+     * When enabled, each thread appends events into its own buffer that
+     * is never shared with other writers, so recording takes no locks.
+     * Buffers are kept after the thread exits so its events can still be
+     * exported.
+     */
+    class Trace
+    {
+    public:
+        struct Event
+        {
+            const char *name; /* must have static storage duration */
+            uint64_t start;   /* ns, steady clock */
+            uint64_t end;     /* ns, steady clock */
+        };
+
+        struct Stage
+        {
+            std::string name;
+            size_t count;
+            uint64_t total; /* ns */
+            uint64_t p50;   /* ns */
+            uint64_t p99;   /* ns */
+            uint64_t max;   /* ns */
+        };
+
+    private:
+        static std::atomic<bool> enabled;
+
+    public:
+        /**
+         * Enable or disable recording of new events.
+         */
+        static void enable(bool enable = true);
+
+        static bool isEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return Current time of the steady clock in nanoseconds.
+         */
+        static uint64_t now();
+
+        /**
+         * Record an event into the buffer of the calling thread.
+         */
+        static void record(const char *name, uint64_t start, uint64_t end);
+
+        /**
+         * @return Number of events that did not fit into thread buffers.
+         */
+        static size_t dropped();
+
+        /**
+         * Compute per-stage statistics of all recorded events, ordered
+         * by stage name.
+         */
+        static std::vector<Stage> summary();
+
+        /**
+         * Write per-stage statistics as a human readable table.
+         */
+        static void writeSummary(std::ostream &stream);
+
+        /**
+         * Write all recorded events in Chrome trace event format, which
+         * can be opened in chrome://tracing or Perfetto.
+         */
+        static void exportChrome(std::ostream &stream);
+
+        /**
+         * Write all recorded events in Chrome trace event format into
+         * file 'filename'.
+         *
+         * @return False if the file could not be written.
+         */
+        static bool exportChrome(const std::string &filename);
+
+        /**
+         * Discard all recorded events. No thread may record events while
+         * this is running.
+         */
+        static void clear();
+    };
+
+    /**
+     * Record the lifetime of this object as event 'name'.
+     */
+    class TraceScope
+    {
+    private:
+        const char *name;
+        uint64_t start;
+
+    public:
+        explicit TraceScope(const char *name)
+            : name(name),
+              start(Trace::isEnabled() ? Trace::now() : 0)
+        {
+            /* noop */
+        }
+
+        ~TraceScope()
+        {
+            if (this->start != 0) {
+                Trace::record(this->name, this->start, Trace::now());
+            }
+        }
+
+    private:
+        TraceScope(const TraceScope &);
+        TraceScope & operator=(const TraceScope &);
+    };
+}
+
+#define ODF_TRACE_CONCAT_(a, b) a ## b
+#define ODF_TRACE_CONCAT(a, b) ODF_TRACE_CONCAT_(a, b)
+
+/**
+ * Trace the rest of the enclosing scope as stage 'name' (string literal).
+ */
+#define ODF_TRACE(name) \
+    ODF::TraceScope ODF_TRACE_CONCAT(odf_trace_, __LINE__)(name)
+
+#endif /* ODF_TRACE_H_ */
@@ -0,0 +1,251 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <new>
+#include <atomic>
+#include <chrono>
+
+#include "bench.h"
+
+/*
+ * Count every C++ heap allocation. OpenCV allocates matrix data through
+ * its own allocator which is not counted, so the number reflects
+ * container and object churn rather than image buffers.
+ */
+static std::atomic<unsigned long> allocations(0);
+
+void * operator new(size_t size)
+{
+    void *ptr;
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+BenchCase::BenchCase(const std::string &name, double pixels,
+                     const Operation &operation)
+    : name(name), pixels(pixels), operation(operation)
+{
+}
+
+BenchCase & BenchSuite::add(const std::string &name, double pixels,
+                            const BenchCase::Operation &operation)
+{
+    this->cases.push_back(BenchCase(name, pixels, operation));
+    return this->cases.back();
+}
+
+BenchRegistrar::BenchRegistrar(BenchRegisterFn fn)
+{
+    BenchRegistrar::registered().push_back(fn);
+}
+
+std::vector<BenchRegisterFn> & BenchRegistrar::registered()
+{
+    static std::vector<BenchRegisterFn> fns;
+    return fns;
+}
+
+struct BenchResult
+{
+    unsigned long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+static BenchResult measure(const BenchCase &bcase, double min_time)
+{
+    typedef std::chrono::steady_clock clock;
+    BenchResult result;
+    unsigned long batch = 1;
+    unsigned long allocs;
+    double elapsed = 0;
+    clock::time_point start;
+
+    /* warm up caches and lazily allocated buffers */
+    bcase.operation();
+
+    result.iterations = 0;
+    allocs = allocations.load();
+    while (elapsed < min_time) {
+        start = clock::now();
+        for (unsigned long i = 0; i < batch; i++) {
+            bcase.operation();
+        }
+        elapsed += std::chrono::duration<double>(clock::now() - start).count();
+        result.iterations += batch;
+        batch *= 2;
+    }
+    allocs = allocations.load() - allocs;
+
+    result.ns_per_op = elapsed * 1e9 / result.iterations;
+    result.allocs_per_op = (double)allocs / result.iterations;
+
+    return result;
+}
+
+static std::string json_string(const std::string &str)
+{
+    std::string out = "\"";
+
+    for (size_t i = 0; i < str.size(); i++) {
+        if (str[i] == '"' || str[i] == '\\') {
+            out += '\\';
+        }
+        out += str[i];
+    }
+
+    return out + "\"";
+}
+
+static void print_result(std::ostream &stream, const BenchCase &bcase,
+                         const BenchResult &result)
+{
+    stream << "    {\"name\": " << json_string(bcase.name) << ", "
+           << "\"params\": {";
+    for (size_t i = 0; i < bcase.params.size(); i++) {
+        stream << (i == 0 ? "" : ", ")
+               << json_string(bcase.params[i].first) << ": "
+               << json_string(bcase.params[i].second);
+    }
+    stream << "}, "
+           << "\"iterations\": " << result.iterations << ", "
+           << "\"ns_per_op\": " << result.ns_per_op << ", "
+           << "\"ops_per_s\": " << 1e9 / result.ns_per_op << ", "
+           << "\"ns_per_pixel\": "
+           << (bcase.pixels > 0 ? result.ns_per_op / bcase.pixels : 0) << ", "
+           << "\"allocs_per_op\": " << result.allocs_per_op << "}";
+}
+
+static void usage(const char *name)
+{
+    std::cerr << "Usage: " << name << " [-f filter] [-t min_time] "
+              << "[-o output] [-l]" << std::endl;
+    std::cerr << "Use -f to run only cases whose name contains 'filter'."
+              << std::endl;
+    std::cerr << "Use -t to set minimal measured time per case in seconds "
+              << "(default 0.5)." << std::endl;
+    std::cerr << "Use -o to write JSON results into file instead of stdout."
+              << std::endl;
+    std::cerr << "Use -l to list cases." << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<BenchRegisterFn> &fns = BenchRegistrar::registered();
+    std::ofstream file;
+    std::ostream *stream = &std::cout;
+    std::string filter;
+    double min_time = 0.5;
+    bool list = false;
+    bool first = true;
+    BenchSuite suite;
+    BenchResult result;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if ((arg == "-f" || arg == "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if ((arg == "-t" || arg == "--min-time") && i + 1 < argc) {
+            min_time = std::atof(argv[++i]);
+        } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            file.open(argv[++i]);
+            if (!file.is_open()) {
+                std::cerr << "Unable to open " << argv[i] << std::endl;
+                return 1;
+            }
+            stream = &file;
+        } else if (arg == "-l" || arg == "--list") {
+            list = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < fns.size(); i++) {
+        fns[i](suite);
+    }
+
+    /* the main thread should be the only one that is measured */
+    cv::setNumThreads(1);
+
+    *stream << "{" << std::endl
+            << "  \"opencv\": " << json_string(CV_VERSION) << "," << std::endl
+            << "  \"min_time\": " << min_time << "," << std::endl
+            << "  \"benchmarks\": [" << std::endl;
+
+    for (size_t i = 0; i < suite.cases.size(); i++) {
+        const BenchCase &bcase = suite.cases[i];
+
+        if (bcase.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        if (list) {
+            std::cerr << bcase.name << std::endl;
+            continue;
+        }
+
+        result = measure(bcase, min_time);
+
+        *stream << (first ? "" : ",\n");
+        print_result(*stream, bcase, result);
+        stream->flush();
+        first = false;
+    }
+
+    *stream << std::endl << "  ]" << std::endl << "}" << std::endl;
+
+    return 0;
+}
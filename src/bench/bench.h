@@ -0,0 +1,109 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <sstream>
+
+/**
+ * Minimal benchmark harness.
+ *
+ * Each benchmark file registers a suite function with ODF_BENCHMARK. The
+ * function adds cases, each with its parameters, number of pixels it
+ * processes per operation (for ns/pixel) and the measured operation.
+ */
+class BenchCase
+{
+public:
+    typedef std::vector<std::pair<std::string, std::string> > Params;
+    typedef std::function<void ()> Operation;
+
+    std::string name;
+    Params params;
+    double pixels;
+    Operation operation;
+
+    BenchCase(const std::string &name, double pixels,
+              const Operation &operation);
+
+    /**
+     * Add parameter shown in the results.
+     */
+    template <typename T>
+    BenchCase & param(const std::string &key, const T &value)
+    {
+        std::ostringstream ss;
+        ss << value;
+        this->params.push_back(std::make_pair(key, ss.str()));
+        return *this;
+    }
+
+    BenchCase & param(const std::string &key, const cv::Size &size)
+    {
+        std::ostringstream ss;
+        ss << size.width << "x" << size.height;
+        return this->param(key, ss.str());
+    }
+};
+
+class BenchSuite
+{
+public:
+    std::vector<BenchCase> cases;
+
+    /**
+     * Add a new case, the operation is run repeatedly.
+     */
+    BenchCase & add(const std::string &name, double pixels,
+                    const BenchCase::Operation &operation);
+};
+
+typedef void (*BenchRegisterFn)(BenchSuite &suite);
+
+class BenchRegistrar
+{
+public:
+    BenchRegistrar(BenchRegisterFn fn);
+
+    static std::vector<BenchRegisterFn> & registered();
+};
+
+/* keep the compiler from optimizing the result away */
+template <typename T>
+inline void bench_use(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#define ODF_BENCHMARK(name) \
+    static void name(BenchSuite &suite); \
+    static BenchRegistrar name ## _registrar(name); \
+    static void name(BenchSuite &suite)
+
+#endif /* BENCH_H_ */
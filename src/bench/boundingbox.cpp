@@ -0,0 +1,65 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+#include <sstream>
+
+#include "bench.h"
+#include "synthetic.h"
+
+using namespace ODF;
+
+/* the name is hidden by hsv_index::SAT from odf/image.h */
+typedef class ODF::SAT SummedAreaTable;
+
+ODF_BENCHMARK(bench_boundingbox)
+{
+    const cv::Size size(640, 480);
+    const unsigned int counts[] = {10, 100, 1000, 5000};
+    SummedAreaTable sat(synthetic_mask(size, 0.3, 6));
+
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        std::vector<cv::Rect> rects = synthetic_rects(size, counts[i], 7);
+        std::ostringstream name;
+
+        name << "boundingbox/push/" << counts[i];
+        suite.add(name.str(), 0, [rects]() {
+            BoundingBoxVector bb;
+            for (size_t j = 0; j < rects.size(); j++) {
+                bb.push(rects[j], 50);
+            }
+            bench_use(bb);
+        }).param("boxes", counts[i]);
+
+        name.str("");
+        name << "boundingbox/push-sat/" << counts[i];
+        suite.add(name.str(), 0, [sat, rects]() {
+            BoundingBoxVector bb(sat, 30 * 30);
+            for (size_t j = 0; j < rects.size(); j++) {
+                bb.push(rects[j]);
+            }
+            bench_use(bb);
+        }).param("boxes", counts[i]);
+    }
+}
@@ -0,0 +1,111 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+#include <sstream>
+#include <memory>
+#include <vector>
+
+#include "bench.h"
+#include "synthetic.h"
+#include "skin.h"
+
+using namespace ODF;
+
+#define FRAMES 8
+
+/*
+ * End to end face-skin like processing of one frame: foreground
+ * detection, skin threshold in HSV, sliding window and highlighting.
+ */
+struct FrameState
+{
+    std::shared_ptr<cv::BackgroundSubtractor> sub;
+    std::vector<cv::Mat> frames;
+    cv::Mat buffer;
+    unsigned int next;
+
+    FrameState(cv::BackgroundSubtractor *sub, const cv::Size &size)
+        : sub(sub), next(0)
+    {
+        cv::Mat background = synthetic_frame(size, 10);
+        cv::Mat fg;
+
+        /* train the model on empty scene, the frames add moving objects */
+        for (int i = 0; i < 20; i++) {
+            (*this->sub)(background, fg);
+        }
+
+        for (int i = 0; i < FRAMES; i++) {
+            cv::Mat frame = background.clone();
+            cv::Mat objects = synthetic_frame(size, 11 + i);
+            objects.copyTo(frame, synthetic_mask(size, 0.2, 11 + i));
+            this->frames.push_back(frame);
+        }
+    }
+
+    void process()
+    {
+        SlidingWindow window(30, 30, 30 / 8, 30 / 8);
+        std::vector<cv::BackgroundSubtractor*> subs(1, this->sub.get());
+        cv::Mat foreground;
+        cv::Mat mask;
+
+        this->frames[this->next].copyTo(this->buffer);
+        this->next = (this->next + 1) % FRAMES;
+
+        Image image("bench.png", this->buffer);
+        foreground = image.getForegroundMask(subs);
+        mask = image.threshold(bench_skin, cv::COLOR_BGR2HSV, foreground);
+
+        BoundingBoxVector bb = window.run(mask, 30);
+        image.highlightObjects(bb, Image::Red);
+    }
+};
+
+ODF_BENCHMARK(bench_frame)
+{
+    std::vector<cv::Size> sizes = bench_resolutions();
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        const cv::Size size = sizes[i];
+        std::shared_ptr<FrameState> mog2;
+        std::shared_ptr<FrameState> running;
+        std::ostringstream name;
+
+        mog2.reset(new FrameState(new cv::BackgroundSubtractorMOG2(), size));
+        name << "frame/mog2/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [mog2]() {
+            mog2->process();
+        }).param("resolution", size).param("background", "MOG2");
+
+        running.reset(new FrameState(new RunningAverageBackgroundSubtractor(),
+                                     size));
+        name.str("");
+        name << "frame/running-average/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [running]() {
+            running->process();
+        }).param("resolution", size).param("background", "running-average");
+    }
+}
@@ -0,0 +1,121 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+#include <sstream>
+
+#include "bench.h"
+#include "synthetic.h"
+#include "common/skin.h"
+
+using namespace ODF;
+
+template <typename Functor>
+static unsigned int count_matches(const cv::Mat &hsv, Functor &fn)
+{
+    unsigned int count = 0;
+
+    for (int i = 0; i < hsv.rows; i++) {
+        const cv::Vec3b *ptr = hsv.ptr<cv::Vec3b>(i);
+        for (int j = 0; j < hsv.cols; j++) {
+            count += fn(ptr[j]) ? 1 : 0;
+        }
+    }
+
+    return count;
+}
+
+ODF_BENCHMARK(bench_rules)
+{
+    std::vector<cv::Size> sizes = bench_resolutions();
+    const RuleSet rules = skin_rules();
+    const BitsetClassifier classifier(rules);
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        const cv::Size size = sizes[i];
+        std::ostringstream name;
+        cv::Mat hsv;
+
+        /* the rules see converted pixels only */
+        cv::cvtColor(synthetic_frame(size, 1), hsv, cv::COLOR_BGR2HSV);
+
+        RuleProfile profile(rules);
+        profile.sample(hsv, cv::Mat(), 16);
+        const RuleSet optimized = rules.optimize(profile);
+        RuleProfile optimized_profile(optimized);
+        optimized_profile.sample(hsv, cv::Mat(), 16);
+
+        name << "rules/chain/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [hsv]() {
+            bench_use(count_matches(hsv, skin_threshold));
+        }).param("resolution", size);
+
+        name.str("");
+        name << "rules/ruleset/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [hsv, rules]() {
+            bench_use(count_matches(hsv, rules));
+        }).param("resolution", size)
+          .param("tests_per_pixel", profile.getTestsPerPixel());
+
+        name.str("");
+        name << "rules/optimized/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [hsv, optimized]() {
+            bench_use(count_matches(hsv, optimized));
+        }).param("resolution", size)
+          .param("tests_per_pixel", optimized_profile.getTestsPerPixel());
+
+        /* after learning, as it runs for the rest of a sequence */
+        AdaptiveRuleSet adaptive(rules);
+        while (adaptive.isLearning()) {
+            count_matches(hsv, adaptive);
+        }
+
+        name.str("");
+        name << "rules/adaptive/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [hsv, adaptive]() mutable {
+            bench_use(count_matches(hsv, adaptive));
+        }).param("resolution", size);
+
+        name.str("");
+        name << "rules/bitset/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [hsv, classifier]() {
+            bench_use(count_matches(hsv, classifier));
+        }).param("resolution", size);
+
+        /* the row kernel Image::classify() uses, the mask is not timed */
+        cv::Mat mask(hsv.rows, hsv.cols, CV_8U);
+
+        name.str("");
+        name << "rules/classify/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(),
+                  [hsv, classifier, mask]() mutable {
+            for (int r = 0; r < hsv.rows; r++) {
+                classifier.classify(hsv.ptr<uchar>(r), mask.ptr<uchar>(r),
+                                    hsv.cols);
+            }
+            bench_use(mask);
+        }).param("resolution", size).param("level",
+                                           CPU::getLevelName(CPU::getLevel()));
+    }
+}
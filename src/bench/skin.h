@@ -0,0 +1,72 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SKIN_H_
+#define SKIN_H_
+
+#include <opencv2/opencv.hpp>
+#include <odf/image.h>
+
+/*
+ * Simplified face-skin threshold, a few hue/saturation/value ranges in
+ * HSV with the same per-pixel cost structure as the sample.
+ */
+inline bool bench_skin(const cv::Vec3b &value)
+{
+    const uchar h = value[0];
+    const uchar s = value[1];
+    const uchar v = value[2];
+
+    if (h == ODF_CONV_HUE(18) && s <= ODF_CONV_SAT(12)) {
+        return false;
+    }
+
+    if (v <= s) {
+        return false;
+    }
+
+    return (h <= ODF_CONV_HUE(25)
+            && s >= ODF_CONV_SAT(10) && s <= ODF_CONV_SAT(45)
+            && v >= ODF_CONV_VAL(30))
+        || (h >= ODF_CONV_HUE(310) && h <= ODF_CONV_HUE(345)
+            && s >= ODF_CONV_SAT(15) && s <= ODF_CONV_SAT(40)
+            && v >= ODF_CONV_VAL(20) && v <= ODF_CONV_VAL(45));
+}
+
+/*
+ * Other detectors run on the same frame: high visibility vests and red
+ * signage.
+ */
+inline bool bench_vest(const cv::Vec3b &value)
+{
+    return value[0] >= ODF_CONV_HUE(30) && value[0] <= ODF_CONV_HUE(70)
+        && value[1] >= ODF_CONV_SAT(60) && value[2] >= ODF_CONV_VAL(50);
+}
+
+inline bool bench_sign(const cv::Vec3b &value)
+{
+    return (value[0] <= ODF_CONV_HUE(10) || value[0] >= ODF_CONV_HUE(340))
+        && value[1] >= ODF_CONV_SAT(50) && value[2] >= ODF_CONV_VAL(30);
+}
+
+#endif /* SKIN_H_ */
@@ -0,0 +1,60 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+#include <sstream>
+
+#include "bench.h"
+#include "synthetic.h"
+
+using namespace ODF;
+
+ODF_BENCHMARK(bench_slidingwindow)
+{
+    std::vector<cv::Size> sizes = bench_resolutions();
+    const double densities[] = {0.05, 0.3, 0.8};
+    const unsigned int windows[] = {20, 30, 60};
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        const cv::Size size = sizes[i];
+
+        for (size_t j = 0; j < sizeof(densities) / sizeof(densities[0]); j++) {
+            cv::Mat mask = synthetic_mask(size, densities[j], 5);
+
+            for (size_t k = 0; k < sizeof(windows) / sizeof(windows[0]); k++) {
+                const unsigned int w = windows[k];
+                SlidingWindow window(w, w, w / 8, w / 8);
+                std::ostringstream name;
+
+                name << "slidingwindow/" << size.width << "x" << size.height
+                     << "/" << densities[j] << "/" << w;
+                suite.add(name.str(), size.area(), [window, mask]() {
+                    bench_use(window.run(mask, 30));
+                }).param("resolution", size)
+                  .param("mask_density", densities[j])
+                  .param("window", w);
+            }
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <algorithm>
+
+#include "synthetic.h"
+
+std::vector<cv::Size> bench_resolutions()
+{
+    std::vector<cv::Size> sizes;
+
+    sizes.push_back(cv::Size(320, 240));
+    sizes.push_back(cv::Size(640, 480));
+    sizes.push_back(cv::Size(1280, 720));
+
+    return sizes;
+}
+
+cv::Mat synthetic_frame(const cv::Size &size, unsigned int seed)
+{
+    cv::RNG rng(seed);
+    cv::Mat frame(size, CV_8UC3);
+    int count = std::max(1, size.area() / (80 * 80));
+
+    rng.fill(frame, cv::RNG::UNIFORM, cv::Scalar::all(0),
+             cv::Scalar::all(256));
+
+    /* skin like patches in BGR */
+    for (int i = 0; i < count; i++) {
+        cv::Point center(rng.uniform(0, size.width),
+                         rng.uniform(0, size.height));
+        cv::Size axes(rng.uniform(10, 40), rng.uniform(15, 50));
+        cv::Scalar color(rng.uniform(90, 140), rng.uniform(120, 170),
+                         rng.uniform(170, 230));
+
+        cv::ellipse(frame, center, axes, 0, 0, 360, color, -1);
+    }
+
+    return frame;
+}
+
+cv::Mat synthetic_mask(const cv::Size &size, double density,
+                       unsigned int seed)
+{
+    cv::RNG rng(seed);
+    cv::Mat mask = cv::Mat::zeros(size, CV_8U);
+    double target = density * size.area();
+    int max_side = std::max(4, std::min(size.width, size.height) / 8);
+
+    while (cv::countNonZero(mask) < target) {
+        cv::Rect rect(rng.uniform(0, size.width), rng.uniform(0, size.height),
+                      rng.uniform(2, max_side), rng.uniform(2, max_side));
+
+        mask(rect & cv::Rect(0, 0, size.width, size.height)) = 255;
+    }
+
+    return mask;
+}
+
+std::vector<cv::Rect> synthetic_rects(const cv::Size &size,
+                                      unsigned int count,
+                                      unsigned int seed)
+{
+    const int window = 30;
+    const int step = window / 8;
+    cv::RNG rng(seed);
+    std::vector<cv::Rect> rects;
+    cv::Point center;
+
+    /* windows overlap inside a cluster, like a scan over a single object */
+    for (unsigned int i = 0; i < count; i++) {
+        if (i % 16 == 0) {
+            center = cv::Point(rng.uniform(0, size.width - window),
+                               rng.uniform(0, size.height - window));
+        }
+
+        rects.push_back(cv::Rect(center.x + rng.uniform(-4, 5) * step,
+                                 center.y + rng.uniform(-4, 5) * step,
+                                 window, window));
+    }
+
+    return rects;
+}
@@ -0,0 +1,47 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SYNTHETIC_H_
+#define SYNTHETIC_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+/* Deterministic inputs, the same seed always gives the same data. */
+
+/* resolutions used by most benchmarks */
+std::vector<cv::Size> bench_resolutions();
+
+/* BGR noise with a few skin coloured blobs */
+cv::Mat synthetic_frame(const cv::Size &size, unsigned int seed);
+
+/* mask covered by rectangular blobs to roughly 'density' (0 - 1) */
+cv::Mat synthetic_mask(const cv::Size &size, double density,
+                       unsigned int seed);
+
+/* 'count' rectangles in clusters, as produced by a window scan */
+std::vector<cv::Rect> synthetic_rects(const cv::Size &size,
+                                      unsigned int count,
+                                      unsigned int seed);
+
+#endif /* SYNTHETIC_H_ */
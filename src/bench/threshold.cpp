@@ -0,0 +1,99 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+#include <sstream>
+
+#include "bench.h"
+#include "synthetic.h"
+#include "skin.h"
+
+using namespace ODF;
+
+ODF_BENCHMARK(bench_threshold)
+{
+    std::vector<cv::Size> sizes = bench_resolutions();
+    const double densities[] = {0.1, 0.5, 1.0};
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        const cv::Size size = sizes[i];
+        Image image("bench.png", synthetic_frame(size, 1));
+        std::ostringstream name;
+
+        name << "threshold/hsv/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [image]() mutable {
+            image.invalidateConversions();
+            bench_use(image.threshold(bench_skin, cv::COLOR_BGR2HSV));
+        }).param("resolution", size).param("convert", "BGR2HSV");
+
+        /* another detector on the same frame reuses the conversion */
+        name.str("");
+        name << "threshold/hsv-cached/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [image]() {
+            bench_use(image.threshold(bench_skin, cv::COLOR_BGR2HSV));
+        }).param("resolution", size).param("convert", "BGR2HSV-cached");
+
+        /* three detectors, separately and in a single pass */
+        name.str("");
+        name << "threshold/hsv-3x/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [image]() mutable {
+            image.invalidateConversions();
+            bench_use(image.threshold(bench_skin, cv::COLOR_BGR2HSV));
+            bench_use(image.threshold(bench_vest, cv::COLOR_BGR2HSV));
+            bench_use(image.threshold(bench_sign, cv::COLOR_BGR2HSV));
+        }).param("resolution", size).param("convert", "BGR2HSV")
+          .param("classes", 3);
+
+        name.str("");
+        name << "threshold/hsv-labels/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [image]() mutable {
+            image.invalidateConversions();
+            bench_use(image.thresholdLabels(cv::COLOR_BGR2HSV, cv::Mat(),
+                                            bench_skin, bench_vest,
+                                            bench_sign));
+        }).param("resolution", size).param("convert", "BGR2HSV")
+          .param("classes", 3);
+
+        name.str("");
+        name << "threshold/bgr/" << size.width << "x" << size.height;
+        suite.add(name.str(), size.area(), [image]() {
+            bench_use(image.threshold(bench_skin));
+        }).param("resolution", size).param("convert", "none");
+
+        /* the mask is what foreground detection gives us */
+        for (size_t j = 0; j < sizeof(densities) / sizeof(densities[0]); j++) {
+            cv::Mat mask = synthetic_mask(size, densities[j], 2);
+
+            name.str("");
+            name << "threshold/hsv-mask/" << size.width << "x" << size.height
+                 << "/" << densities[j];
+            suite.add(name.str(), size.area(), [image, mask]() mutable {
+                image.invalidateConversions();
+                bench_use(image.threshold(bench_skin, cv::COLOR_BGR2HSV,
+                                          mask));
+            }).param("resolution", size).param("convert", "BGR2HSV")
+              .param("mask_density", densities[j]);
+        }
+    }
+}
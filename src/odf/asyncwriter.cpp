@@ -0,0 +1,181 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdexcept>
+#include <memory>
+#include <odf/asyncwriter.h>
+#include <odf/threadpool.h>
+#include <odf/trace.h>
+#include <odf/metrics.h>
+
+using namespace ODF;
+
+AsyncWriter::AsyncWriter(unsigned int num_threads,
+                         size_t capacity,
+                         const std::vector<int> &params,
+                         const Callback &callback)
+    : queue(capacity),
+      threads(),
+      params(params),
+      callback(callback),
+      pending(0),
+      num_failures(0),
+      num_written(0)
+{
+    if (num_threads == 0) {
+        num_threads = ThreadPool::defaultSize();
+    }
+
+    for (unsigned int i = 0; i < num_threads; i++) {
+        this->threads.push_back(std::thread(&AsyncWriter::worker, this));
+    }
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    /* threads drain the queue before they see it closed */
+    this->queue.close();
+
+    for (unsigned int i = 0; i < this->threads.size(); i++) {
+        this->threads[i].join();
+    }
+}
+
+void AsyncWriter::write(const Image &image, const std::string &filename,
+                        bool copy)
+{
+    if (!image.isOpen()) {
+        throw std::logic_error("Image is not opened!");
+    }
+
+    this->write(image.getImage(), image.formatFilename(filename), copy);
+}
+
+void AsyncWriter::write(const cv::Mat &matrix, const std::string &filename,
+                        bool copy)
+{
+    Job *job = new Job();
+
+    job->filename = filename;
+    job->matrix = copy ? matrix.clone() : matrix;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending++;
+    }
+
+    if (!this->queue.push(job)) {
+        /* only possible while destroying the writer */
+        this->finish(job, false, "Writer is closed");
+        delete job;
+    }
+}
+
+void AsyncWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (this->pending != 0) {
+        this->done.wait(lock);
+    }
+}
+
+unsigned long AsyncWriter::failures() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->num_failures;
+}
+
+unsigned long AsyncWriter::written() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->num_written;
+}
+
+/* the error text is best effort, running out of memory must not throw */
+static void set_error(std::string &error, const char *message)
+{
+    try {
+        error = message;
+    } catch (...) {
+        error.clear();
+    }
+}
+
+void AsyncWriter::worker()
+{
+    Job *job;
+    bool success;
+    std::string error;
+
+    while (this->queue.pop(job)) {
+        std::unique_ptr<Job> owned(job);
+
+        error.clear();
+        success = false;
+
+        try {
+            ODF_TRACE("save");
+            Metrics::add(Metrics::EncodeBytes,
+                         job->matrix.total() * job->matrix.elemSize());
+            success = cv::imwrite(job->filename, job->matrix, this->params);
+            if (!success) {
+                error = "Unable to write " + job->filename;
+            }
+        } catch (std::exception &e) {
+            /* also cv::Exception, anything else must not kill the thread */
+            success = false;
+            set_error(error, e.what());
+        } catch (...) {
+            success = false;
+            set_error(error, "Unknown error while writing image");
+        }
+
+        this->finish(job, success, error);
+    }
+}
+
+void AsyncWriter::finish(const Job *job, bool success,
+                         const std::string &error)
+{
+    if (this->callback) {
+        try {
+            this->callback(job->filename, success, error);
+        } catch (...) {
+            /* do not let the callback kill the writer thread */
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (success) {
+        this->num_written++;
+    } else {
+        this->num_failures++;
+    }
+
+    this->pending--;
+    if (this->pending == 0) {
+        this->done.notify_all();
+    }
+}
@@ -0,0 +1,475 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+#include <odf/background.h>
+
+#define ODF_MOG2_MAGIC "ODFMOG2\0"
+#define ODF_MOG2_VERSION 1
+
+using namespace ODF;
+
+ScaledBackgroundSubtractor::ScaledBackgroundSubtractor(cv::BackgroundSubtractor *sub,
+                                                       unsigned int scale,
+                                                       bool refine)
+    : sub(sub),
+      scale(scale),
+      refine(refine)
+{
+    int size;
+
+    if (scale == 0) {
+        throw std::logic_error("Scale must not be zero");
+    }
+
+    /* keep roughly the same 5x5 opening as in full resolution, smaller
+     * kernels would only erode the mask */
+    size = 5 / scale;
+    if (size >= 2) {
+        size |= 1;
+        this->kernel = cv::getStructuringElement(cv::MORPH_RECT,
+                                                 cv::Size(size, size));
+    }
+}
+
+ScaledBackgroundSubtractor::~ScaledBackgroundSubtractor()
+{
+    delete this->sub;
+}
+
+void ScaledBackgroundSubtractor::operator()(cv::InputArray image,
+                                            cv::OutputArray fgmask,
+                                            double learningRate)
+{
+    cv::Mat frame = image.getMat();
+    cv::Mat mask;
+
+    if (this->scale == 1) {
+        this->small_image = frame;
+    } else {
+        cv::resize(frame, this->small_image,
+                   cv::Size(std::max(frame.cols / (int)this->scale, 1),
+                            std::max(frame.rows / (int)this->scale, 1)),
+                   0, 0, cv::INTER_AREA);
+    }
+
+    this->sub->operator()(this->small_image, this->small_mask, learningRate);
+
+    if (!this->kernel.empty()) {
+        cv::morphologyEx(this->small_mask, this->small_mask, cv::MORPH_OPEN,
+                         this->kernel);
+    }
+
+    /* shadows (127) count as foreground as they do at full resolution */
+    cv::threshold(this->small_mask, this->small_mask, 0, 255,
+                  cv::THRESH_BINARY);
+
+    fgmask.create(frame.size(), CV_8U);
+    mask = fgmask.getMat();
+
+    if (this->scale == 1) {
+        this->small_mask.copyTo(mask);
+    } else if (this->refine) {
+        /* majority of the neighbouring low resolution pixels decides */
+        cv::resize(this->small_mask, mask, frame.size(), 0, 0,
+                   cv::INTER_LINEAR);
+        cv::threshold(mask, mask, 127, 255, cv::THRESH_BINARY);
+    } else {
+        cv::resize(this->small_mask, mask, frame.size(), 0, 0,
+                   cv::INTER_NEAREST);
+    }
+}
+
+void ScaledBackgroundSubtractor::getBackgroundImage(cv::OutputArray image) const
+{
+    cv::Mat background;
+
+    this->sub->getBackgroundImage(background);
+
+    if (this->scale == 1 || background.empty()) {
+        background.copyTo(image);
+        return;
+    }
+
+    cv::resize(background, image,
+               cv::Size(background.cols * this->scale,
+                        background.rows * this->scale),
+               0, 0, cv::INTER_LINEAR);
+}
+
+unsigned int ScaledBackgroundSubtractor::getScale() const
+{
+    return this->scale;
+}
+
+cv::BackgroundSubtractor *ScaledBackgroundSubtractor::getSubtractor() const
+{
+    return this->sub;
+}
+
+PersistentBackgroundSubtractorMOG2::PersistentBackgroundSubtractorMOG2()
+    : cv::BackgroundSubtractorMOG2()
+{
+    /* noop */
+}
+
+PersistentBackgroundSubtractorMOG2::PersistentBackgroundSubtractorMOG2(int history,
+                                                                       float varThreshold,
+                                                                       bool bShadowDetection)
+    : cv::BackgroundSubtractorMOG2(history, varThreshold, bShadowDetection)
+{
+    /* noop */
+}
+
+struct ModelHeader
+{
+    char magic[8];
+    int32_t version;
+    int32_t nmixtures;
+    int32_t nframes;
+    int32_t frame_width;
+    int32_t frame_height;
+    int32_t frame_type;
+    int32_t model_type;
+    int32_t model_rows;
+    int32_t model_cols;
+    int32_t reserved;
+};
+
+static void write_mat(std::ostream &out, const cv::Mat &mat)
+{
+    for (int i = 0; i < mat.rows; i++) {
+        out.write((const char*)mat.ptr(i), mat.cols * mat.elemSize());
+    }
+}
+
+static void read_mat(std::istream &in, cv::Mat &mat)
+{
+    for (int i = 0; i < mat.rows; i++) {
+        in.read((char*)mat.ptr(i), mat.cols * mat.elemSize());
+    }
+}
+
+void PersistentBackgroundSubtractorMOG2::saveModel(std::ostream &out) const
+{
+    ModelHeader header;
+
+    if (!this->isTrained()) {
+        throw std::logic_error("Background model is not trained");
+    }
+
+    memset(&header, 0, sizeof(ModelHeader));
+    memcpy(header.magic, ODF_MOG2_MAGIC, 8);
+    header.version = ODF_MOG2_VERSION;
+    header.nmixtures = this->nmixtures;
+    header.nframes = this->nframes;
+    header.frame_width = this->frameSize.width;
+    header.frame_height = this->frameSize.height;
+    header.frame_type = this->frameType;
+    header.model_type = this->bgmodel.type();
+    header.model_rows = this->bgmodel.rows;
+    header.model_cols = this->bgmodel.cols;
+
+    out.write((const char*)&header, sizeof(ModelHeader));
+    write_mat(out, this->bgmodel);
+    write_mat(out, this->bgmodelUsedModes);
+
+    if (!out.good()) {
+        throw std::runtime_error("Unable to write background model");
+    }
+}
+
+bool PersistentBackgroundSubtractorMOG2::loadModel(std::istream &in)
+{
+    ModelHeader header;
+    cv::Mat model;
+    cv::Mat used_modes;
+    uint64_t pixels;
+    uint64_t values;
+    uint64_t per_pixel;
+
+    in.read((char*)&header, sizeof(ModelHeader));
+    if (!in.good() || memcmp(header.magic, ODF_MOG2_MAGIC, 8) != 0
+            || header.version != ODF_MOG2_VERSION) {
+        return false;
+    }
+
+    /* the model layout depends on the number of gaussians */
+    if (header.nmixtures != this->nmixtures || header.frame_width <= 0
+            || header.frame_height <= 0 || header.model_rows <= 0
+            || header.model_cols <= 0 || header.model_type != CV_32F
+            || (header.frame_type & ~CV_MAT_TYPE_MASK) != 0
+            || CV_MAT_DEPTH(header.frame_type) != CV_8U
+            || CV_MAT_CN(header.frame_type) > 4) {
+        return false;
+    }
+
+    /* weight, variance and mean of each gaussian per pixel, MOG2 reads
+     * that much without checking the model size */
+    pixels = (uint64_t)header.frame_width * header.frame_height;
+    values = (uint64_t)header.model_rows * header.model_cols;
+    per_pixel = (uint64_t)header.nmixtures
+                * (2 + CV_MAT_CN(header.frame_type));
+    if (values % per_pixel != 0 || values / per_pixel != pixels) {
+        return false;
+    }
+
+    model.create(header.model_rows, header.model_cols, header.model_type);
+    used_modes.create(header.frame_height, header.frame_width, CV_8U);
+    read_mat(in, model);
+    read_mat(in, used_modes);
+    if (!in.good()) {
+        return false;
+    }
+
+    this->frameSize = cv::Size(header.frame_width, header.frame_height);
+    this->frameType = header.frame_type;
+    this->nframes = header.nframes;
+    this->bgmodel = model;
+    this->bgmodelUsedModes = used_modes;
+
+    return true;
+}
+
+void PersistentBackgroundSubtractorMOG2::saveModel(const std::string &filename) const
+{
+    /* write a new file and rename it, a crash must not destroy the last
+     * good checkpoint */
+    std::string tmp = filename + ".tmp";
+    std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary
+                                   | std::ios::trunc);
+
+    if (!out.is_open()) {
+        throw std::runtime_error("Unable to write background model into "
+                                 + filename);
+    }
+
+    this->saveModel(out);
+    out.close();
+
+    if (out.fail() || rename(tmp.c_str(), filename.c_str()) != 0) {
+        throw std::runtime_error("Unable to write background model into "
+                                 + filename);
+    }
+}
+
+bool PersistentBackgroundSubtractorMOG2::loadModel(const std::string &filename)
+{
+    std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!in.is_open()) {
+        return false;
+    }
+
+    return this->loadModel(in);
+}
+
+bool PersistentBackgroundSubtractorMOG2::isTrained() const
+{
+    return this->nframes > 0 && !this->bgmodel.empty();
+}
+
+#define ODF_RA_MAX_SHIFT 20
+
+/**
+ * Update running average of a row stripe.
+ */
+class RunningAverageBody : public cv::ParallelLoopBody
+{
+private:
+    const cv::Mat &image;
+    cv::Mat &mean;
+    cv::Mat &variance;
+    cv::Mat &mask;
+    int shift; /* negative means no update */
+    uint32_t var_threshold;
+    uint32_t var_min;
+
+public:
+    RunningAverageBody(const cv::Mat &image, cv::Mat &mean,
+                       cv::Mat &variance, cv::Mat &mask, int shift,
+                       uint32_t var_threshold, uint32_t var_min)
+        : image(image), mean(mean), variance(variance), mask(mask),
+          shift(shift), var_threshold(var_threshold), var_min(var_min)
+    {
+        /* noop */
+    }
+
+    void operator()(const cv::Range &range) const
+    {
+        int channels = this->image.channels();
+        int length = this->image.cols * channels;
+        std::vector<uchar> fg(length);
+
+        for (int y = range.start; y < range.end; y++) {
+            const uchar *src = this->image.ptr<uchar>(y);
+            uint32_t *m = this->mean.ptr<uint32_t>(y);
+            uint32_t *v = this->variance.ptr<uint32_t>(y);
+            uchar *dst = this->mask.ptr<uchar>(y);
+
+            if (this->shift < 0) {
+                this->classify(src, m, v, &fg[0], length);
+            } else {
+                this->update(src, m, v, &fg[0], length);
+            }
+
+            /* foreground if any channel is */
+            for (int x = 0; x < this->image.cols; x++) {
+                uchar value = 0;
+                for (int c = 0; c < channels; c++) {
+                    value |= fg[x * channels + c];
+                }
+                dst[x] = value;
+            }
+        }
+    }
+
+private:
+    /* x * 2^-s rounded to nearest, x + 2^(s-1) must not overflow */
+    static inline uint32_t rshift(uint32_t x, int s)
+    {
+        return (x + ((1u << s) >> 1)) >> s;
+    }
+
+    void classify(const uchar *src, const uint32_t *m, const uint32_t *v,
+                  uchar *fg, int length) const
+    {
+        for (int i = 0; i < length; i++) {
+            /* Q8.23 difference to Q8.8, squared to Q16.16 */
+            int32_t diff = ((int32_t)src[i] << 23) - (int32_t)m[i];
+            uint32_t d = (uint32_t)(diff < 0 ? -diff : diff) >> 15;
+
+            fg[i] = (uint64_t)(d * d) > (uint64_t)v[i] * this->var_threshold
+                    ? 255 : 0;
+        }
+    }
+
+    void update(const uchar *src, uint32_t *m, uint32_t *v,
+                uchar *fg, int length) const
+    {
+        const int s = this->shift;
+
+        for (int i = 0; i < length; i++) {
+            int32_t diff = ((int32_t)src[i] << 23) - (int32_t)m[i];
+            int32_t sign = diff >> 31;
+            uint32_t a = (uint32_t)((diff ^ sign) - sign);
+            uint32_t d = a >> 15;
+            uint32_t d2 = d * d;
+            uint32_t var = v[i];
+
+            fg[i] = (uint64_t)d2 > (uint64_t)var * this->var_threshold
+                    ? 255 : 0;
+
+            /* mean += alpha * diff, var += alpha * (d^2 - var), both
+             * rounded symmetrically so the model does not drift */
+            m[i] = (uint32_t)((int32_t)m[i]
+                              + (((int32_t)rshift(a, s) ^ sign) - sign));
+            var = var - rshift(var, s) + rshift(d2, s);
+            v[i] = var < this->var_min ? this->var_min : var;
+        }
+    }
+};
+
+RunningAverageBackgroundSubtractor::RunningAverageBackgroundSubtractor(unsigned int shift,
+                                                                       float var_threshold,
+                                                                       float var_init,
+                                                                       float var_min)
+    : mean(),
+      variance(),
+      size(),
+      type(-1),
+      shift(std::min(shift, (unsigned int)ODF_RA_MAX_SHIFT)),
+      var_threshold(cv::saturate_cast<uchar>(var_threshold)),
+      var_init(var_init * 65536),
+      var_min(var_min * 65536)
+{
+    if (this->var_threshold == 0) {
+        this->var_threshold = 1;
+    }
+}
+
+void RunningAverageBackgroundSubtractor::operator()(cv::InputArray image,
+                                                    cv::OutputArray fgmask,
+                                                    double learningRate)
+{
+    cv::Mat frame = image.getMat();
+    cv::Mat mask;
+    int shift;
+
+    if (frame.depth() != CV_8U || frame.channels() > 4) {
+        throw std::logic_error("Only 8-bit images with up to 4 channels "
+                               "are supported");
+    }
+
+    fgmask.create(frame.size(), CV_8U);
+    mask = fgmask.getMat();
+
+    if (learningRate >= 1 || frame.size() != this->size
+            || frame.type() != this->type) {
+        /* start a new model from this frame */
+        this->size = frame.size();
+        this->type = frame.type();
+        frame.reshape(1).convertTo(this->mean, CV_32S, 1 << 23);
+        this->variance.create(frame.rows, frame.cols * frame.channels(),
+                              CV_32S);
+        this->variance.setTo(this->var_init);
+        mask.setTo(0);
+        return;
+    }
+
+    if (learningRate < 0) {
+        shift = this->shift;
+    } else if (learningRate == 0) {
+        shift = -1;
+    } else {
+        shift = cvRound(-log(learningRate) / log(2.0));
+        shift = std::max(0, std::min(shift, ODF_RA_MAX_SHIFT));
+    }
+
+    cv::parallel_for_(cv::Range(0, frame.rows),
+                      RunningAverageBody(frame, this->mean, this->variance,
+                                         mask, shift, this->var_threshold,
+                                         this->var_min));
+}
+
+void RunningAverageBackgroundSubtractor::getBackgroundImage(cv::OutputArray image) const
+{
+    cv::Mat background;
+
+    if (this->mean.empty()) {
+        image.release();
+        return;
+    }
+
+    /* Q8.23 to 8-bit, rounded */
+    this->mean.convertTo(background, CV_8U, 1.0 / (1 << 23));
+    background.reshape(CV_MAT_CN(this->type), this->size.height)
+              .copyTo(image);
+}
@@ -22,6 +22,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include <odf/boundingbox.h>
+#include <odf/trace.h>
+#include <odf/metrics.h>
+#include <odf/private/kernels.h>
 
 using namespace ODF;
 
@@ -95,16 +98,17 @@ cv::Rect BoundingBox::getBoundingBox() const
 
 cv::Rect BoundingBox::getBestFitBox() const
 {
-    return this->bounding_box;
+    return this->best_fit_box;
 }
 
 double BoundingBox::getFillRatio() const
 {
-    return this->getFillRatio();
+    return this->fill_ratio;
 }
 
 BoundingBoxVector::BoundingBoxVector()
     : vector(),
+      rects(),
       sat(),
       area(0),
       area_set(false)
@@ -114,6 +118,7 @@ BoundingBoxVector::BoundingBoxVector()
 
 BoundingBoxVector::BoundingBoxVector(const SAT &sat)
     : vector(),
+      rects(),
       sat(sat),
       area(0),
       area_set(false)
@@ -123,6 +128,7 @@ BoundingBoxVector::BoundingBoxVector(const SAT &sat)
 
 BoundingBoxVector::BoundingBoxVector(const SAT &sat, unsigned int area)
     : vector(),
+      rects(),
       sat(sat),
       area(area),
       area_set(true)
@@ -146,18 +152,43 @@ void BoundingBoxVector::push(const cv::Rect &rect)
 void BoundingBoxVector::push(const cv::Rect &rect, double fill_ratio)
 {
     iterator it;
-    bool found;
 
-    for (it = this->vector.begin(); it != this->vector.end(); it++) {
-        found = it->expandIfIntersect(rect, fill_ratio);
-        if (found) {
-            break;
-        }
+    ODF_TRACE("merge");
+
+    it = this->findIntersection(rect);
+    if (it == this->vector.end()) {
+        this->append(BoundingBox(rect, fill_ratio));
+        return;
     }
 
-    if (!found) {
-        this->vector.push_back(BoundingBox(rect, fill_ratio));
+    it->expand(rect, fill_ratio);
+    this->updateRect(it);
+    Metrics::add(Metrics::BoxMerges, 1);
+}
+
+void BoundingBoxVector::push(const BoundingBox &box)
+{
+    iterator it;
+
+    ODF_TRACE("merge");
+
+    it = this->findIntersection(box.getBoundingBox());
+    if (it == this->vector.end()) {
+        this->append(box);
+        return;
     }
+
+    it->expand(box.getBestFitBox(), box.getFillRatio());
+    it->expand(box.getBoundingBox());
+    this->updateRect(it);
+    Metrics::add(Metrics::BoxMerges, 1);
+}
+
+void BoundingBoxVector::append(const BoundingBox &box)
+{
+    this->vector.push_back(box);
+    this->rects.resize(this->rects.size() + 4);
+    this->updateRect(this->vector.end() - 1);
 }
 
 size_t BoundingBoxVector::size() const
@@ -209,3 +240,28 @@ BoundingBoxVector::const_reverse_iterator BoundingBoxVector::rend() const
 {
     return this->vector.rend();
 }
+
+BoundingBoxVector::iterator BoundingBoxVector::findIntersection(const cv::Rect &rect)
+{
+    const int r[4] = {rect.x, rect.y, rect.width, rect.height};
+    size_t index;
+
+    if (this->vector.empty()) {
+        return this->vector.end();
+    }
+
+    index = getKernels().firstIntersect(&this->rects[0], 4,
+                                        this->vector.size(), r);
+
+    return this->vector.begin() + index;
+}
+
+void BoundingBoxVector::updateRect(iterator it)
+{
+    int *rect = &this->rects[4 * (it - this->vector.begin())];
+
+    rect[0] = it->bounding_box.x;
+    rect[1] = it->bounding_box.y;
+    rect[2] = it->bounding_box.width;
+    rect[3] = it->bounding_box.height;
+}
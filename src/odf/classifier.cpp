@@ -0,0 +1,237 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <odf/classifier.h>
+#include <odf/resultcache.h>
+#include <odf/private/kernels.h>
+
+#define ODF_CLASSIFIER_MAGIC "ODFRULES"
+#define ODF_CLASSIFIER_VERSION 1
+
+using namespace ODF;
+
+struct ClassifierHeader
+{
+    char magic[8];
+    int32_t version;
+    int32_t num_rules;
+    int32_t fallback;
+    int32_t conversion;
+    uint64_t source;
+};
+
+BitsetClassifier::BitsetClassifier()
+    : decisive(0),
+      num_rules(0),
+      fallback(false),
+      conversion(cv::COLOR_COLORCVT_MAX),
+      source(0)
+{
+    for (unsigned int c = 0; c < 3; c++) {
+        std::fill(this->tables[c], this->tables[c] + 256, 0);
+    }
+    std::fill(this->pairs, this->pairs + 6, 0);
+}
+
+BitsetClassifier::BitsetClassifier(const RuleSet &rules)
+    : decisive(0),
+      num_rules(rules.size()),
+      fallback(rules.getFallback()),
+      conversion(rules.getConversion()),
+      source(0)
+{
+    if (rules.size() > MaxRules) {
+        throw std::logic_error("Too many rules for bitset classifier!");
+    }
+
+    for (unsigned int c = 0; c < 3; c++) {
+        std::fill(this->tables[c], this->tables[c] + 256, 0);
+    }
+    std::fill(this->pairs, this->pairs + 6, 0);
+
+    for (unsigned int i = 0; i < this->num_rules; i++) {
+        const ColorRule &rule = rules[i];
+        const uint32_t bit = (uint32_t)1 << i;
+        bool possible = true;
+
+        for (size_t k = 0; k < rule.getComparisons().size(); k++) {
+            unsigned int a = rule.getComparisons()[k].first;
+            unsigned int b = rule.getComparisons()[k].second;
+
+            /* value[a] > value[a] never holds */
+            if (a == b) {
+                possible = false;
+                break;
+            }
+
+            this->pairs[a * 2 + (b + 3 - a) % 3 - 1] |= bit;
+        }
+
+        if (!possible) {
+            continue;
+        }
+
+        for (unsigned int c = 0; c < 3; c++) {
+            for (unsigned int v = 0; v < 256; v++) {
+                if (rule.allows(c, v)) {
+                    this->tables[c][v] |= bit;
+                }
+            }
+        }
+
+        if (rule.accepts() != this->fallback) {
+            this->decisive |= bit;
+        }
+    }
+}
+
+BitsetClassifier BitsetClassifier::load(const std::string &rules_file,
+                                        const std::string &cache_file /*= ""*/)
+{
+    std::ifstream file(rules_file.c_str());
+    std::ostringstream content;
+    std::istringstream rules;
+    BitsetClassifier classifier;
+    uint64_t source;
+
+    if (!file.is_open() || !(content << file.rdbuf())) {
+        throw std::runtime_error("Unable to read " + rules_file);
+    }
+
+    source = ResultCache::hash(content.str());
+    if (!cache_file.empty() && classifier.loadTables(cache_file, source)) {
+        return classifier;
+    }
+
+    /* compile what was hashed, the file may have changed since */
+    rules.str(content.str());
+    classifier = BitsetClassifier(RuleSet::parse(rules, rules_file));
+    classifier.source = source;
+
+    if (!cache_file.empty()) {
+        try {
+            classifier.save(cache_file);
+        } catch (const std::runtime_error &) {
+            /* the cache only saves time on the next start */
+        }
+    }
+
+    return classifier;
+}
+
+void BitsetClassifier::save(const std::string &filename) const
+{
+    /* write a new file and rename it, readers must not see a part */
+    std::string tmp = filename + ".tmp";
+    std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary
+                                   | std::ios::trunc);
+    ClassifierHeader header;
+
+    if (!out.is_open()) {
+        throw std::runtime_error("Unable to write classifier into "
+                                 + filename);
+    }
+
+    memset(&header, 0, sizeof(ClassifierHeader));
+    memcpy(header.magic, ODF_CLASSIFIER_MAGIC, 8);
+    header.version = ODF_CLASSIFIER_VERSION;
+    header.num_rules = this->num_rules;
+    header.fallback = this->fallback;
+    header.conversion = this->conversion;
+    header.source = this->source;
+
+    out.write((const char*)&header, sizeof(ClassifierHeader));
+    out.write((const char*)this->tables, sizeof(this->tables));
+    out.write((const char*)this->pairs, sizeof(this->pairs));
+    out.write((const char*)&this->decisive, sizeof(this->decisive));
+    out.close();
+
+    if (out.fail() || rename(tmp.c_str(), filename.c_str()) != 0) {
+        throw std::runtime_error("Unable to write classifier into "
+                                 + filename);
+    }
+}
+
+void BitsetClassifier::classify(const uchar *pixels, uchar *out,
+                                size_t count) const
+{
+    getKernels().classifyRow(pixels, out, count, this->tables[0],
+                             this->pairs, this->decisive,
+                             this->fallback ? 255 : 0);
+}
+
+unsigned int BitsetClassifier::size() const
+{
+    return this->num_rules;
+}
+
+bool BitsetClassifier::getFallback() const
+{
+    return this->fallback;
+}
+
+unsigned int BitsetClassifier::getConversion() const
+{
+    return this->conversion;
+}
+
+bool BitsetClassifier::loadTables(const std::string &filename,
+                                  uint64_t source)
+{
+    std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+    ClassifierHeader header;
+    BitsetClassifier loaded;
+
+    if (!in.is_open()) {
+        return false;
+    }
+
+    in.read((char*)&header, sizeof(ClassifierHeader));
+    if (!in.good() || memcmp(header.magic, ODF_CLASSIFIER_MAGIC, 8) != 0
+            || header.version != ODF_CLASSIFIER_VERSION
+            || header.source != source || header.num_rules < 0
+            || header.num_rules > (int32_t)MaxRules) {
+        return false;
+    }
+
+    in.read((char*)loaded.tables, sizeof(loaded.tables));
+    in.read((char*)loaded.pairs, sizeof(loaded.pairs));
+    in.read((char*)&loaded.decisive, sizeof(loaded.decisive));
+    if (!in.good()) {
+        return false;
+    }
+
+    loaded.num_rules = header.num_rules;
+    loaded.fallback = header.fallback != 0;
+    loaded.conversion = header.conversion;
+    loaded.source = source;
+    *this = loaded;
+
+    return true;
+}
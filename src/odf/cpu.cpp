@@ -0,0 +1,167 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <odf/cpu.h>
+#include <odf/private/kernels.h>
+
+using namespace ODF;
+
+namespace
+{
+    const char *level_names[] = {"generic", "sse4", "avx2", "avx512"};
+
+    /* highest level the processor can run, checked by cpuid */
+    CPU::Level detect_level()
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f")
+                && __builtin_cpu_supports("avx512bw")) {
+            return CPU::AVX512;
+        }
+
+        if (__builtin_cpu_supports("avx2")) {
+            return CPU::AVX2;
+        }
+
+        if (__builtin_cpu_supports("sse4.2")) {
+            return CPU::SSE4;
+        }
+#endif
+
+        return CPU::Generic;
+    }
+
+    /* kernels of 'level' or NULL if they were not built */
+    const Kernels * kernels_for(CPU::Level level)
+    {
+        switch (level) {
+#ifdef ODF_WITH_AVX512
+        case CPU::AVX512:
+            return &kernels_avx512;
+#endif
+#ifdef ODF_WITH_AVX2
+        case CPU::AVX2:
+            return &kernels_avx2;
+#endif
+#ifdef ODF_WITH_SSE4
+        case CPU::SSE4:
+            return &kernels_sse4;
+#endif
+        case CPU::Generic:
+            return &kernels_generic;
+        default:
+            return NULL;
+        }
+    }
+
+    CPU::Level supported_level()
+    {
+        int level = detect_level();
+
+        while (kernels_for(static_cast<CPU::Level>(level)) == NULL) {
+            level--;
+        }
+
+        return static_cast<CPU::Level>(level);
+    }
+
+    const Kernels * select_kernels()
+    {
+        CPU::Level supported = supported_level();
+        CPU::Level level = supported;
+        const char *env = std::getenv("ODF_CPU_LEVEL");
+        int forced = -1;
+
+        if (env == NULL) {
+            return kernels_for(level);
+        }
+
+        for (int i = CPU::Generic; i <= CPU::AVX512; i++) {
+            if (std::strcmp(env, level_names[i]) == 0) {
+                forced = i;
+                break;
+            }
+        }
+
+        if (forced < 0) {
+            std::fprintf(stderr, "ODF_CPU_LEVEL: unknown level '%s', "
+                         "using %s\n", env, level_names[level]);
+            return kernels_for(level);
+        }
+
+        if (forced > supported) {
+            std::fprintf(stderr, "ODF_CPU_LEVEL: %s is not supported by "
+                         "this processor or build, using %s\n",
+                         env, level_names[level]);
+            return kernels_for(level);
+        }
+
+        /* the forced level may have been left out of the build */
+        level = static_cast<CPU::Level>(forced);
+        while (kernels_for(level) == NULL) {
+            level = static_cast<CPU::Level>(level - 1);
+        }
+
+        if (level != forced) {
+            std::fprintf(stderr, "ODF_CPU_LEVEL: %s is not built, using %s\n",
+                         env, level_names[level]);
+        }
+
+        return kernels_for(level);
+    }
+
+    /* select kernels when the library is loaded */
+    struct SelectAtLoad
+    {
+        SelectAtLoad()
+        {
+            getKernels();
+        }
+    } select_at_load;
+}
+
+const Kernels & ODF::getKernels()
+{
+    static const Kernels *kernels = select_kernels();
+    return *kernels;
+}
+
+CPU::Level CPU::getLevel()
+{
+    return getKernels().level;
+}
+
+CPU::Level CPU::getSupportedLevel()
+{
+    return supported_level();
+}
+
+const char * CPU::getLevelName(Level level)
+{
+    return level_names[level];
+}
@@ -0,0 +1,155 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdexcept>
+#include <sstream>
+#include <cstring>
+#include <odf/detectionlog.h>
+
+#define ODF_DETECTIONLOG_MAGIC "ODFDETv1"
+
+using namespace ODF;
+
+/* binary records are little endian, as is every platform we run on */
+template <typename T>
+static void put(std::ostream &out, T value)
+{
+    out.write((const char*)&value, sizeof(T));
+}
+
+static void put_rect(std::ostream &out, const cv::Rect &rect)
+{
+    put<int32_t>(out, rect.x);
+    put<int32_t>(out, rect.y);
+    put<int32_t>(out, rect.width);
+    put<int32_t>(out, rect.height);
+}
+
+static std::string escape_json(const std::string &str)
+{
+    std::ostringstream out;
+
+    for (size_t i = 0; i < str.length(); i++) {
+        switch (str[i]) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        default:
+            if ((unsigned char)str[i] < 0x20) {
+                out << "\\u00" << std::hex << (str[i] >> 4)
+                    << (str[i] & 0xf) << std::dec;
+            } else {
+                out << str[i];
+            }
+            break;
+        }
+    }
+
+    return out.str();
+}
+
+DetectionLog::DetectionLog(const std::string &filename, Format format)
+    : file(),
+      filename(filename),
+      format(format)
+{
+    this->file.open(filename.c_str(), std::ios::out | std::ios::trunc
+                    | (format == Binary ? std::ios::binary
+                                        : std::ios::openmode(0)));
+    if (!this->file.is_open()) {
+        throw std::runtime_error("Unable to create " + filename);
+    }
+
+    if (format == Binary) {
+        this->file.write(ODF_DETECTIONLOG_MAGIC, 8);
+    }
+}
+
+void DetectionLog::write(uint64_t frame, const std::string &name,
+                         const BoundingBoxVector &objects)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->format == Binary) {
+        this->writeBinary(frame, name, objects);
+    } else {
+        this->writeJSON(frame, name, objects);
+    }
+
+    if (!this->file.good()) {
+        throw std::runtime_error("Unable to write into " + this->filename);
+    }
+}
+
+void DetectionLog::flush()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->file.flush();
+}
+
+void DetectionLog::writeJSON(uint64_t frame, const std::string &name,
+                             const BoundingBoxVector &objects)
+{
+    BoundingBoxVector::const_iterator it;
+    cv::Rect box;
+    cv::Rect best;
+
+    this->file << "{\"frame\":" << frame
+               << ",\"name\":\"" << escape_json(name) << "\",\"boxes\":[";
+
+    for (it = objects.begin(); it != objects.end(); it++) {
+        box = it->getBoundingBox();
+        best = it->getBestFitBox();
+
+        this->file << (it == objects.begin() ? "" : ",")
+                   << "{\"x\":" << box.x << ",\"y\":" << box.y
+                   << ",\"w\":" << box.width << ",\"h\":" << box.height
+                   << ",\"best\":[" << best.x << "," << best.y << ","
+                   << best.width << "," << best.height << "]"
+                   << ",\"fill\":" << it->getFillRatio() << "}";
+    }
+
+    this->file << "]}\n";
+}
+
+void DetectionLog::writeBinary(uint64_t frame, const std::string &name,
+                               const BoundingBoxVector &objects)
+{
+    BoundingBoxVector::const_iterator it;
+    uint16_t name_length = name.length() > 0xffff ? 0xffff : name.length();
+
+    put<uint64_t>(this->file, frame);
+    put<uint16_t>(this->file, name_length);
+    this->file.write(name.data(), name_length);
+    put<uint32_t>(this->file, objects.size());
+
+    for (it = objects.begin(); it != objects.end(); it++) {
+        put_rect(this->file, it->getBoundingBox());
+        put_rect(this->file, it->getBestFitBox());
+        put<float>(this->file, it->getFillRatio());
+    }
+}
@@ -0,0 +1,200 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdio>
+#include <stdint.h>
+#include <odf/framesource.h>
+#include <odf/trace.h>
+#include <odf/metrics.h>
+
+using namespace ODF;
+
+FrameSource::~FrameSource()
+{
+    /* noop */
+}
+
+FrameSource::Accessor::Accessor(FrameSource *source, bool copy)
+    : source(source),
+      copy(copy),
+      fetched(0),
+      finished(false)
+{
+    /* noop */
+}
+
+size_t FrameSource::Accessor::size() const
+{
+    /* unknown, next() returns NULL at the end */
+    return SIZE_MAX;
+}
+
+Image *FrameSource::Accessor::operator()(size_t index,
+                                         std::unique_ptr<Image> &storage) const
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    Image *image;
+
+    /* frames must be fetched in index order so the ordered run delivers
+     * them in the right sequence */
+    this->fetched_cond.wait(lock, [&]() {
+        return this->finished || this->fetched == index;
+    });
+
+    if (this->finished) {
+        return NULL;
+    }
+
+    try {
+        image = this->source->next();
+        if (image != NULL && this->copy) {
+            /* the source may reuse its buffer for the next frame */
+            storage.reset(new Image(image->clone()));
+            image = storage.get();
+        }
+    } catch (...) {
+        /* release workers waiting for the following frames */
+        this->finished = true;
+        this->fetched_cond.notify_all();
+        throw;
+    }
+
+    if (image == NULL) {
+        this->finished = true;
+        this->fetched_cond.notify_all();
+        return NULL;
+    }
+
+    this->fetched++;
+    this->fetched_cond.notify_all();
+
+    return image;
+}
+
+VideoSource::VideoSource(const std::string &filename,
+                         const std::string &extension /*= "png"*/)
+    : capture(filename),
+      basename(filename),
+      extension(extension),
+      index(0),
+      buffer(),
+      frame(filename)
+{
+    size_t pos;
+
+    if (!this->capture.isOpened()) {
+        throw std::runtime_error("Unable to open video " + filename);
+    }
+
+    /* strip extension */
+    pos = this->basename.find_last_of("./\\");
+    if (pos != std::string::npos && this->basename[pos] == '.') {
+        this->basename.erase(pos);
+    }
+}
+
+VideoSource::VideoSource(int device,
+                         const std::string &extension /*= "png"*/)
+    : capture(device),
+      basename(),
+      extension(extension),
+      index(0),
+      buffer(),
+      frame("")
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "camera%d", device);
+    this->basename = name;
+
+    if (!this->capture.isOpened()) {
+        throw std::runtime_error("Unable to open capture device "
+                                 + this->basename);
+    }
+}
+
+Image *VideoSource::next()
+{
+    char number[32];
+
+    ODF_TRACE("load");
+
+    if (!this->capture.read(this->buffer) || this->buffer.empty()) {
+        return NULL;
+    }
+
+    Metrics::add(Metrics::DecodeBytes,
+                 this->buffer.total() * this->buffer.elemSize());
+
+    snprintf(number, sizeof(number), "-%06u.", this->index++);
+    this->frame = Image(this->basename + number + this->extension,
+                        this->buffer);
+
+    return &this->frame;
+}
+
+ImageSequenceSource::ImageSequenceSource(ImageSequence &sequence)
+    : sequence(&sequence),
+      it(sequence.begin()),
+      started(false)
+{
+    /* noop */
+}
+
+Image *ImageSequenceSource::next()
+{
+    if (this->it == this->sequence->end()) {
+        return NULL;
+    }
+
+    if (this->started) {
+        this->it++;
+    }
+
+    this->started = true;
+
+    if (this->it == this->sequence->end()) {
+        return NULL;
+    }
+
+    return &(*this->it);
+}
+
+LazyImageSequenceSource::LazyImageSequenceSource(const LazyImageSequence &sequence)
+    : sequence(&sequence),
+      current(),
+      index(0)
+{
+    /* noop */
+}
+
+Image *LazyImageSequenceSource::next()
+{
+    if (this->index >= this->sequence->size()) {
+        return NULL;
+    }
+
+    this->current.reset(new Image(this->sequence->getFilename(this->index++)));
+
+    return this->current.get();
+}
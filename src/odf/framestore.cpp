@@ -0,0 +1,295 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <odf/framestore.h>
+
+#define ODF_FRAMESTORE_MAGIC "ODFSTORE"
+#define ODF_FRAMESTORE_VERSION 1
+
+using namespace ODF;
+
+static uint64_t align(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static void write_or_throw(FILE *file, const void *data, size_t size,
+                           const std::string &filename)
+{
+    if (size != 0 && fwrite(data, size, 1, file) != 1) {
+        fclose(file);
+        throw std::runtime_error("Unable to write frame store " + filename);
+    }
+}
+
+FrameStore::FrameStore(const std::string &filename)
+    : filename(filename),
+      map(NULL),
+      map_size(0),
+      header(NULL)
+{
+    struct stat st;
+    void *ptr;
+    int fd;
+
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Unable to open frame store " + filename
+                                 + ": " + strerror(errno));
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error("Invalid frame store " + filename);
+    }
+
+    /* private writable mapping: painting into frames must not modify
+     * the file */
+    ptr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        throw std::runtime_error("Unable to map frame store " + filename
+                                 + ": " + strerror(errno));
+    }
+
+    this->map = (uchar*)ptr;
+    this->map_size = st.st_size;
+    this->header = (const Header*)ptr;
+
+    if (!FrameStore::isValid(this->header, this->map_size)) {
+        munmap(this->map, this->map_size);
+        throw std::runtime_error("Invalid frame store " + filename);
+    }
+
+    /* frames are read sequentially in most cases */
+    madvise(this->map, this->map_size, MADV_SEQUENTIAL);
+}
+
+/*
+ * Check that all frames and names of the store lie within 'size' bytes,
+ * the arithmetic must not overflow for a crafted or truncated file.
+ */
+bool FrameStore::isValid(const Header *header, size_t size)
+{
+    uint64_t row_size;
+
+    if (memcmp(header->magic, ODF_FRAMESTORE_MAGIC, 8) != 0
+            || header->version != ODF_FRAMESTORE_VERSION
+            || header->data_offset < sizeof(Header)
+            || header->data_offset > header->names_offset
+            || header->names_offset > size
+            || header->count > (size - header->names_offset)
+                               / ODF_FRAMESTORE_NAME_SIZE) {
+        return false;
+    }
+
+    if (header->count == 0) {
+        return true;
+    }
+
+    if (header->rows <= 0 || header->cols <= 0
+            || (header->type & ~CV_MAT_TYPE_MASK) != 0
+            || CV_MAT_DEPTH(header->type) > CV_64F) {
+        return false;
+    }
+
+    row_size = (uint64_t)header->cols * CV_ELEM_SIZE(header->type);
+
+    return header->step >= row_size
+           && header->step <= header->frame_size / header->rows
+           && header->count <= (header->names_offset - header->data_offset)
+                               / header->frame_size;
+}
+
+FrameStore::~FrameStore()
+{
+    munmap(this->map, this->map_size);
+}
+
+size_t FrameStore::create(const std::string &filename,
+                          FrameSource &source,
+                          unsigned int convert_to /*= cv::COLOR_COLORCVT_MAX*/)
+{
+    std::vector<std::string> names;
+    std::vector<char> padding;
+    std::vector<char> name(ODF_FRAMESTORE_NAME_SIZE);
+    Header header;
+    cv::Mat converted;
+    const cv::Mat *mat;
+    Image *image;
+    size_t row_size;
+    FILE *file;
+
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, ODF_FRAMESTORE_MAGIC, 8);
+    header.version = ODF_FRAMESTORE_VERSION;
+    header.convert_to = convert_to;
+    header.data_offset = align(sizeof(Header), ODF_FRAMESTORE_FRAME_ALIGN);
+
+    file = fopen(filename.c_str(), "wb");
+    if (file == NULL) {
+        throw std::runtime_error("Unable to create frame store " + filename
+                                 + ": " + strerror(errno));
+    }
+
+    /* header is written at the end when we know all values */
+    padding.resize(header.data_offset, 0);
+    write_or_throw(file, &padding[0], padding.size(), filename);
+
+    while ((image = source.next()) != NULL) {
+        if (!image->open()) {
+            continue;
+        }
+
+        mat = &image->getImage();
+        if (convert_to != cv::COLOR_COLORCVT_MAX) {
+            cv::cvtColor(*mat, converted, convert_to);
+            mat = &converted;
+        }
+
+        if (header.count == 0) {
+            header.rows = mat->rows;
+            header.cols = mat->cols;
+            header.type = mat->type();
+            header.step = align(mat->cols * mat->elemSize(),
+                                ODF_FRAMESTORE_ROW_ALIGN);
+            header.frame_size = align(header.step * mat->rows,
+                                      ODF_FRAMESTORE_FRAME_ALIGN);
+            padding.assign(header.frame_size, 0);
+        } else if (mat->rows != header.rows || mat->cols != header.cols
+                   || mat->type() != header.type) {
+            fclose(file);
+            throw std::runtime_error("Frame " + image->getName() + " differs "
+                                     "in size or type from the first frame");
+        }
+
+        row_size = mat->cols * mat->elemSize();
+        for (int i = 0; i < mat->rows; i++) {
+            write_or_throw(file, mat->ptr(i), row_size, filename);
+            write_or_throw(file, &padding[0], header.step - row_size, filename);
+        }
+
+        write_or_throw(file, &padding[0],
+                       header.frame_size - header.step * mat->rows, filename);
+
+        names.push_back(image->getFilename());
+        header.count++;
+    }
+
+    header.names_offset = header.data_offset
+                          + header.count * header.frame_size;
+
+    for (size_t i = 0; i < names.size(); i++) {
+        std::fill(name.begin(), name.end(), 0);
+        names[i].copy(&name[0], ODF_FRAMESTORE_NAME_SIZE - 1);
+        write_or_throw(file, &name[0], name.size(), filename);
+    }
+
+    if (fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        throw std::runtime_error("Unable to write frame store " + filename);
+    }
+
+    write_or_throw(file, &header, sizeof(Header), filename);
+
+    if (fclose(file) != 0) {
+        throw std::runtime_error("Unable to write frame store " + filename);
+    }
+
+    return header.count;
+}
+
+size_t FrameStore::size() const
+{
+    return this->header->count;
+}
+
+unsigned int FrameStore::getConversion() const
+{
+    return this->header->convert_to;
+}
+
+Image FrameStore::operator[](size_t index) const
+{
+    const char *name;
+    uchar *data;
+
+    if (index >= this->size()) {
+        throw std::out_of_range("Frame index is out of range");
+    }
+
+    name = (const char*)(this->map + this->header->names_offset
+                         + index * ODF_FRAMESTORE_NAME_SIZE);
+    data = this->map + this->header->data_offset
+           + index * this->header->frame_size;
+
+    return Image(std::string(name, strnlen(name, ODF_FRAMESTORE_NAME_SIZE)),
+                 cv::Mat(this->header->rows, this->header->cols,
+                         this->header->type, data, this->header->step));
+}
+
+FrameStore::Accessor::Accessor(const FrameStore *store)
+    : store(store)
+{
+    /* noop */
+}
+
+size_t FrameStore::Accessor::size() const
+{
+    return this->store->size();
+}
+
+Image *FrameStore::Accessor::operator()(size_t index,
+                                        std::unique_ptr<Image> &storage) const
+{
+    storage.reset(new Image((*this->store)[index]));
+
+    return storage.get();
+}
+
+FrameStoreSource::FrameStoreSource(const FrameStore &store)
+    : store(&store),
+      current(),
+      index(0)
+{
+    /* noop */
+}
+
+Image *FrameStoreSource::next()
+{
+    if (this->index >= this->store->size()) {
+        return NULL;
+    }
+
+    this->current.reset(new Image((*this->store)[this->index++]));
+
+    return this->current.get();
+}
@@ -24,7 +24,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <exception>
+#include <system_error>
 #include <odf/image.h>
+#include <odf/threadpool.h>
+#include <odf/trace.h>
+#include <odf/metrics.h>
+#include <odf/classifier.h>
+#include <odf/private/kernels.h>
 
 using namespace ODF;
 
@@ -37,18 +45,90 @@ const cv::Vec3b Image::V_Green = cv::Vec3b(0, 255, 0);
 const cv::Vec3b Image::V_Blue = cv::Vec3b(255, 0, 0);
 
 Image::Image(const std::string &filename)
-    : filename(filename),
-      is_opened(false)
+    : is_opened(false),
+      roi()
 {
-    size_t pos = this->filename.find_last_of("/\\");
+    this->setFilename(filename);
+}
 
-    if (pos == std::string::npos) {
-        this->path = std::string();
-        this->name = this->filename;
-    } else {
-        this->path = this->filename.substr(0, pos);
-        this->name = this->filename.substr(pos + 1);
+Image::Image(const std::string &filename, const cv::Mat &image)
+    : image(image),
+      is_opened(true),
+      roi()
+{
+    this->setFilename(filename);
+}
+
+Image::Image(const std::string &filename, int rows, int cols, int type,
+             void *data, size_t step /*= cv::Mat::AUTO_STEP*/)
+    : image(rows, cols, type, data, step),
+      is_opened(true),
+      roi()
+{
+    this->setFilename(filename);
+}
+
+Image::Image(const Image &other)
+    : filename(other.filename),
+      path(other.path),
+      name(other.name),
+      image(other.image),
+      is_opened(other.is_opened),
+      roi(other.roi)
+{
+    std::lock_guard<std::mutex> guard(other.conversions_lock);
+    this->conversions = other.conversions;
+}
+
+Image & Image::operator=(const Image &other)
+{
+    std::map<unsigned int, cv::Mat> conversions;
+
+    if (this == &other) {
+        return *this;
     }
+
+    {
+        std::lock_guard<std::mutex> guard(other.conversions_lock);
+        conversions = other.conversions;
+    }
+
+    this->filename = other.filename;
+    this->path = other.path;
+    this->name = other.name;
+    this->image = other.image;
+    this->is_opened = other.is_opened;
+    this->roi = other.roi;
+    this->conversions.swap(conversions);
+
+    return *this;
+}
+
+Image Image::clone() const
+{
+    Image copy(*this);
+
+    if (this->is_opened) {
+        copy.image = this->image.clone();
+    }
+
+    return copy;
+}
+
+Image Image::crop(const cv::Rect &rect, unsigned int padding) const
+{
+    this->assertIsOpen();
+
+    cv::Rect region(rect.x - (int)padding, rect.y - (int)padding,
+                    rect.width + 2 * (int)padding,
+                    rect.height + 2 * (int)padding);
+
+    region &= cv::Rect(0, 0, this->image.cols, this->image.rows);
+    if (region.area() == 0) {
+        throw std::logic_error("Crop region is outside of the image!");
+    }
+
+    return Image(this->filename, this->image(region));
 }
 
 bool Image::open()
@@ -57,11 +137,16 @@ bool Image::open()
         return true;
     }
 
+    ODF_TRACE("load");
+
     this->image = cv::imread(this->filename);
     if (this->image.data == NULL) {
         return false;
     }
 
+    Metrics::add(Metrics::DecodeBytes,
+                 this->image.total() * this->image.elemSize());
+
     this->is_opened = true;
 
     return true;
@@ -74,6 +159,7 @@ void Image::close()
     }
 
     this->image.release();
+    this->conversions.clear();
     this->is_opened = false;
 }
 
@@ -104,24 +190,40 @@ bool Image::save(std::string filename) const
 {
     this->assertIsOpen();
 
+    ODF_TRACE("save");
+
+    Metrics::add(Metrics::EncodeBytes,
+                 this->image.total() * this->image.elemSize());
+
+    return cv::imwrite(this->formatFilename(filename), this->image);
+}
+
+std::string Image::formatFilename(std::string filename) const
+{
     size_t pos = filename.find('%');
     while (pos != std::string::npos) {
         switch (filename[pos + 1]) {
         case 'n':
             filename.replace(pos, 2, this->name);
+            pos += this->name.length();
             break;
         case 'p':
             filename.replace(pos, 2, this->path);
+            pos += this->path.length();
             break;
         case '%':
             filename.replace(pos, 2, "%");
+            pos += 1;
+            break;
+        default:
+            pos += 1;
             break;
         }
 
         pos = filename.find('%', pos);
     }
 
-    return cv::imwrite(filename, this->image);
+    return filename;
 }
 
 void Image::replaceImage(const cv::Mat &new_image)
@@ -131,16 +233,26 @@ void Image::replaceImage(const cv::Mat &new_image)
     }
 
     this->image = new_image;
+    this->conversions.clear();
     this->is_opened = true;
 }
 
+void Image::invalidateConversions()
+{
+    this->conversions.clear();
+}
+
 void Image::applyMask(const cv::Mat &mask)
 {
     this->assertIsOpen();
 
     cv::Mat new_image;
 
+    ODF_TRACE("mask");
+
     this->image.copyTo(new_image, mask);
+    Metrics::add(Metrics::BytesAllocated,
+                 new_image.total() * new_image.elemSize());
     this->replaceImage(new_image);
 }
 
@@ -152,27 +264,192 @@ cv::Mat Image::getForegroundMask(cv::BackgroundSubtractor *sub) const
     return this->getForegroundMask(subs);
 }
 
-cv::Mat Image::getForegroundMask(std::vector<cv::BackgroundSubtractor*> subs) const
+cv::Mat Image::getForegroundMask(const std::vector<cv::BackgroundSubtractor*> &subs) const
+{
+    ForegroundBuffers buffers;
+    cv::Mat mask;
+
+    this->getForegroundMask(subs, buffers, mask);
+
+    return mask;
+}
+
+/**
+ * Run background subtractors and their morphology, one subtractor per
+ * index of the range.
+ */
+class ForegroundBody : public cv::ParallelLoopBody
+{
+private:
+    const cv::Mat &image;
+    const std::vector<cv::BackgroundSubtractor*> &subs;
+    ForegroundBuffers &buffers;
+    std::vector<cv::Mat> &masks;
+    std::vector<std::exception_ptr> &errors;
+    const cv::Mat &kernel;
+
+public:
+    ForegroundBody(const cv::Mat &image,
+                   const std::vector<cv::BackgroundSubtractor*> &subs,
+                   ForegroundBuffers &buffers,
+                   std::vector<cv::Mat> &masks,
+                   std::vector<std::exception_ptr> &errors,
+                   const cv::Mat &kernel)
+        : image(image), subs(subs), buffers(buffers), masks(masks),
+          errors(errors), kernel(kernel)
+    {
+        /* noop */
+    }
+
+    void operator()(const cv::Range &range) const
+    {
+        for (int i = range.start; i < range.end; i++) {
+            try {
+                /* we want a very slow learning rate */
+                this->subs[i]->operator()(this->image, this->masks[i],
+                                          0.00001);
+
+                if (!this->buffers.isCleaned(i)) {
+                    cv::morphologyEx(this->masks[i], this->masks[i],
+                                     cv::MORPH_OPEN, this->kernel);
+                }
+            } catch (...) {
+                /* exceptions must not escape OpenCV worker threads */
+                this->errors[i] = std::current_exception();
+            }
+        }
+    }
+};
+
+/**
+ * AND the subtractor masks, split by rows.
+ */
+class ForegroundReduceBody : public cv::ParallelLoopBody
+{
+private:
+    const std::vector<cv::Mat> &buffers;
+    cv::Mat &mask;
+
+public:
+    ForegroundReduceBody(const std::vector<cv::Mat> &buffers, cv::Mat &mask)
+        : buffers(buffers), mask(mask)
+    {
+        /* noop */
+    }
+
+    void operator()(const cv::Range &range) const
+    {
+        cv::Mat rows = this->mask.rowRange(range.start, range.end);
+
+        rows.setTo(1);
+        for (size_t i = 0; i < this->buffers.size(); i++) {
+            cv::bitwise_and(rows,
+                            this->buffers[i].rowRange(range.start, range.end),
+                            rows);
+        }
+    }
+};
+
+ForegroundBuffers::ForegroundBuffers()
+    : masks(),
+      cleaned(),
+      pool()
+{
+    /* noop */
+}
+
+ForegroundBuffers::~ForegroundBuffers()
+{
+    /* noop, ThreadPool is complete here */
+}
+
+void ForegroundBuffers::setCleaned(size_t index, bool cleaned /*= true*/)
+{
+    if (index >= this->cleaned.size()) {
+        this->cleaned.resize(index + 1, false);
+    }
+
+    this->cleaned[index] = cleaned;
+}
+
+bool ForegroundBuffers::isCleaned(size_t index) const
+{
+    return index < this->cleaned.size() && this->cleaned[index];
+}
+
+void Image::getForegroundMask(const std::vector<cv::BackgroundSubtractor*> &subs,
+                              ForegroundBuffers &buffers,
+                              cv::Mat &mask) const
 {
     this->assertIsOpen();
 
-    std::vector<cv::BackgroundSubtractor*>::iterator it;
-    cv::Mat kernel;
-    cv::Mat tmpmask;
-    cv::Mat mask;
+    static const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT,
+                                                            cv::Size(5, 5));
+    std::vector<std::exception_ptr> errors(subs.size());
+    std::vector<cv::Mat> &masks = buffers.masks;
+    cv::Rect area = this->_processedArea();
+    cv::Mat frame = this->image(area);
+    cv::Mat part;
+    size_t inline_from = subs.size();
 
-    mask = cv::Mat::ones(this->image.rows, this->image.cols, CV_8U);
-    kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5));
+    ODF_TRACE("background");
 
-    for (it = subs.begin(); it != subs.end(); it++) {
-        /* we want a very slow learning rate */
-        (*it)->operator()(this->image, tmpmask, 0.00001);
+    masks.resize(subs.size());
+    mask.create(this->image.rows, this->image.cols, CV_8U);
 
-        cv::morphologyEx(tmpmask, tmpmask, cv::MORPH_OPEN, kernel);
-        mask &= tmpmask;
+    if (area.area() == 0) {
+        mask.setTo(0);
+        return;
     }
 
-    return mask;
+    /* the models see only the region of interest */
+    ForegroundBody body(frame, subs, buffers, masks, errors, kernel);
+
+    /* OpenCV runs nested parallel_for_ serially, so the subtractors get
+     * their own threads and keep their internal row parallelism */
+    if (subs.size() > 1
+            && (!buffers.pool || buffers.pool->size() != subs.size() - 1)) {
+        try {
+            buffers.pool.reset();
+            buffers.pool.reset(new ThreadPool(subs.size() - 1));
+        } catch (const std::system_error &) {
+            /* run the subtractors one after another */
+            buffers.pool.reset();
+        }
+    }
+
+    if (buffers.pool) {
+        for (size_t i = 1; i < subs.size(); i++) {
+            buffers.pool->submit([&body, i]() {
+                body(cv::Range(i, i + 1));
+            });
+        }
+
+        inline_from = std::min<size_t>(subs.size(), 1);
+    }
+
+    body(cv::Range(0, inline_from));
+    if (buffers.pool) {
+        buffers.pool->wait();
+    }
+
+    for (size_t i = 0; i < errors.size(); i++) {
+        if (errors[i]) {
+            std::rethrow_exception(errors[i]);
+        }
+    }
+
+    if (this->roi) {
+        mask.setTo(0);
+    }
+
+    part = mask(area);
+    cv::parallel_for_(cv::Range(0, area.height),
+                      ForegroundReduceBody(masks, part));
+
+    if (this->roi) {
+        cv::bitwise_and(part, this->roi->getMask()(area), part);
+    }
 }
 
 void Image::highlightObjects(const BoundingBoxVector &objects,
@@ -186,6 +463,8 @@ void Image::highlightObjects(const BoundingBoxVector &objects,
     for (it = objects.begin(); it != objects.end(); it++) {
         cv::rectangle(this->image, it->getBoundingBox(), color, thickness);
     }
+
+    this->invalidateConversions();
 }
 
 void Image::highlightObjects(const std::vector<cv::Rect> &objects,
@@ -199,6 +478,64 @@ void Image::highlightObjects(const std::vector<cv::Rect> &objects,
     for (it = objects.begin(); it != objects.end(); it++) {
         cv::rectangle(this->image, *it, color, thickness);
     }
+
+    this->invalidateConversions();
+}
+
+cv::Mat Image::classify(const BitsetClassifier &classifier) const
+{
+    return this->_classify(classifier, NULL, cv::COLOR_COLORCVT_MAX);
+}
+
+cv::Mat Image::classify(const BitsetClassifier &classifier,
+                        const cv::Mat &mask) const
+{
+    return this->_classify(classifier, &mask, cv::COLOR_COLORCVT_MAX);
+}
+
+cv::Mat Image::classify(const BitsetClassifier &classifier,
+                        unsigned int convert_to) const
+{
+    return this->_classify(classifier, NULL, convert_to);
+}
+
+cv::Mat Image::classify(const BitsetClassifier &classifier,
+                        unsigned int convert_to,
+                        const cv::Mat &mask) const
+{
+    return this->_classify(classifier, &mask, convert_to);
+}
+
+std::vector<cv::Mat> Image::splitLabels(const cv::Mat &labels,
+                                        unsigned int count)
+{
+    std::vector<cv::Mat> masks(count);
+    std::vector<uchar*> mptrs(count);
+    const uchar *lptr = NULL;
+
+    if (count > 8) {
+        throw std::logic_error("Label mask has at most eight classes!");
+    }
+
+    for (unsigned int k = 0; k < count; k++) {
+        masks[k].create(labels.rows, labels.cols, CV_8U);
+    }
+
+    /* read the labels once for all classes */
+    for (int i = 0; i < labels.rows; i++) {
+        lptr = labels.ptr<uchar>(i);
+        for (unsigned int k = 0; k < count; k++) {
+            mptrs[k] = masks[k].ptr<uchar>(i);
+        }
+
+        for (int j = 0; j < labels.cols; j++) {
+            for (unsigned int k = 0; k < count; k++) {
+                mptrs[k][j] = (lptr[j] >> k) & 1 ? 255 : 0;
+            }
+        }
+    }
+
+    return masks;
 }
 
 const std::string & Image::getName() const
@@ -208,7 +545,12 @@ const std::string & Image::getName() const
 
 const std::string & Image::getPath() const
 {
-    return this->name;
+    return this->path;
+}
+
+const std::string & Image::getFilename() const
+{
+    return this->filename;
 }
 
 const cv::Mat & Image::getImage() const
@@ -218,31 +560,165 @@ const cv::Mat & Image::getImage() const
     return this->image;
 }
 
-void Image::assertIsOpen() const throw (std::logic_error)
+void Image::setRegionOfInterest(const std::shared_ptr<const RegionOfInterest> &roi)
+{
+    /* conversions cover only the processed area */
+    if (roi != this->roi) {
+        this->invalidateConversions();
+    }
+
+    this->roi = roi;
+}
+
+const RegionOfInterest * Image::getRegionOfInterest() const
+{
+    return this->roi.get();
+}
+
+void Image::setFilename(const std::string &filename)
+{
+    size_t pos = filename.find_last_of("/\\");
+
+    this->filename = filename;
+
+    if (pos == std::string::npos) {
+        this->path = std::string();
+        this->name = this->filename;
+    } else {
+        this->path = this->filename.substr(0, pos);
+        this->name = this->filename.substr(pos + 1);
+    }
+}
+
+void Image::assertIsOpen() const
 {
     if (!this->is_opened) {
         throw std::logic_error("Image is not opened");
     }
 }
 
-cv::Mat Image::_thresholdGetImage(const cv::Mat *mask,
-                                  unsigned int convert_to) const
+cv::Rect Image::_processedArea() const
 {
-    const cv::Mat *ptr = &this->image;
+    if (!this->roi) {
+        return cv::Rect(0, 0, this->image.cols, this->image.rows);
+    }
+
+    if (this->roi->getSize() != cv::Size(this->image.cols, this->image.rows)) {
+        throw std::logic_error("Region of interest does not match image size!");
+    }
+
+    return this->roi->getBoundingRect();
+}
+
+cv::Mat Image::_thresholdGetImage(unsigned int convert_to,
+                                  const cv::Rect &area) const
+{
+    std::map<unsigned int, cv::Mat>::iterator it;
     cv::Mat converted_image;
-    cv::Mat masked_image;
 
-    if (convert_to != cv::COLOR_COLORCVT_MAX) {
-        cv::cvtColor(this->image, converted_image, convert_to);
-        ptr = &converted_image;
+    if (convert_to == cv::COLOR_COLORCVT_MAX) {
+        return this->image(area);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(this->conversions_lock);
+
+        it = this->conversions.find(convert_to);
+        if (it != this->conversions.end()
+                && it->second.size() == area.size()) {
+            return it->second;
+        }
     }
 
-    if (mask != NULL) {
-        ptr->copyTo(masked_image, *mask);
-        ptr = &masked_image;
+    ODF_TRACE("convert");
+
+    /* converted outside of the lock, a concurrent conversion of the same
+     * code only wastes time */
+    cv::cvtColor(this->image(area), converted_image, convert_to);
+    Metrics::add(Metrics::BytesAllocated,
+                 converted_image.total() * converted_image.elemSize());
+
+    std::lock_guard<std::mutex> guard(this->conversions_lock);
+    this->conversions[convert_to] = converted_image;
+
+    return converted_image;
+}
+
+cv::Mat Image::_classify(const BitsetClassifier &classifier,
+                         const cv::Mat *input_mask,
+                         unsigned int convert_to) const
+{
+    std::vector<RegionOfInterest::Span> whole;
+    const uchar *iptr = NULL; /* image data pointer */
+    const uchar *fptr = NULL; /* input mask data pointer */
+    uchar *mptr = NULL; /* mask data pointer */
+    uint64_t pixels = 0;
+    uint64_t masked = 0;
+    uchar masked_value;
+    const Kernels &kernels = getKernels();
+    cv::Rect area;
+    cv::Mat image;
+    cv::Mat mask;
+
+    ODF_TRACE("threshold");
+
+    mask = cv::Mat::zeros(this->image.rows, this->image.cols, CV_8U);
+    area = this->_processedArea();
+    if (area.area() == 0) {
+        return mask;
     }
 
-    return *ptr;
+    image = this->_thresholdGetImage(convert_to, area);
+    if (image.type() != CV_8UC3) {
+        throw std::logic_error("Classifier needs image with three channels!");
+    }
+
+    if (input_mask != NULL && input_mask->empty()) {
+        input_mask = NULL;
+    }
+    masked_value = classifier(cv::Vec3b::all(0)) ? 255 : 0;
+    whole.push_back(RegionOfInterest::Span(area.x, area.x + area.width));
+
+    for (int i = 0; i < area.height; i++) {
+        const std::vector<RegionOfInterest::Span> &spans =
+            !this->roi ? whole : this->roi->getSpans(area.y + i);
+
+        iptr = image.ptr<uchar>(i);
+        mptr = mask.ptr<uchar>(area.y + i);
+        fptr = input_mask == NULL ? NULL
+                                  : input_mask->ptr<uchar>(area.y + i);
+
+        /* classify whole spans, masked pixels are overwritten after */
+        for (size_t s = 0; s < spans.size(); s++) {
+            const int start = spans[s].first;
+            const int count = spans[s].second - spans[s].first;
+
+            pixels += count;
+            classifier.classify(&iptr[(start - area.x) * 3], &mptr[start],
+                                count);
+            if (fptr != NULL) {
+                masked += kernels.fillMasked(&fptr[start], &mptr[start],
+                                             count, masked_value);
+            }
+        }
+    }
+
+    this->_countThreshold(pixels, masked, false, 0);
+
+    return mask;
+}
+
+void Image::_countThreshold(uint64_t pixels, uint64_t masked,
+                            bool probed, unsigned int functors) const
+{
+    uint64_t bytes = this->image.rows * this->image.cols;
+
+    /* the probe decides value of all masked pixels */
+    Metrics::add(Metrics::PixelsThresholded, pixels);
+    Metrics::add(Metrics::PixelsMasked, masked);
+    Metrics::add(Metrics::FunctorCalls,
+                 (pixels - masked + (probed ? 1 : 0)) * functors);
+    Metrics::add(Metrics::BytesAllocated, bytes);
 }
 
 ImageSequence::ImageSequence()
@@ -0,0 +1,186 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Portable kernel implementations. This file is compiled once per
+ * instruction set level with different architecture flags and the
+ * compiler vectorises the loops for each of them. The including file
+ * defines ODF_KERNELS_TABLE and ODF_KERNELS_LEVEL.
+ *
+ * Do not include headers with inline functions or templates here. The
+ * linker may keep their copy built with the architecture flags and use
+ * it everywhere, also on processors that can not run it.
+ */
+
+#include <odf/private/kernels.h>
+
+#if !defined(ODF_KERNELS_TABLE) || !defined(ODF_KERNELS_LEVEL)
+#error "ODF_KERNELS_TABLE and ODF_KERNELS_LEVEL must be defined"
+#endif
+
+/* rectangles are tested in blocks without early exit so they vectorise */
+#define INTERSECT_BLOCK 16
+
+namespace
+{
+    size_t fill_masked(const unsigned char *mask, unsigned char *out,
+                       size_t count, unsigned char value)
+    {
+        size_t masked = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            bool zero = mask[i] == 0;
+            out[i] = zero ? value : out[i];
+            masked += zero;
+        }
+
+        return masked;
+    }
+
+    void integral_row(const unsigned char *mask, const int *above,
+                      int *out, int cols)
+    {
+        int sum = 0;
+
+        /* values 0 and 255 count as 0 and 1, as mask / 255 would do */
+        out[0] = 0;
+        for (int x = 0; x < cols; x++) {
+            sum += mask[x] >> 7;
+            out[x + 1] = sum;
+        }
+
+        for (int x = 1; x <= cols; x++) {
+            out[x] += above[x];
+        }
+    }
+
+    void window_ratios(const int *top, const int *bottom, int x, int width,
+                       int step, int count, unsigned int area,
+                       double *ratios)
+    {
+        for (int k = 0; k < count; k++) {
+            int x1 = x + k * step;
+            int x2 = x1 + width;
+            int sum = bottom[x2] - bottom[x1] - top[x2] + top[x1];
+
+            /* the same expression as SAT::fillRatio() */
+            ratios[k] = sum * 100.0 / area;
+        }
+    }
+
+    size_t first_intersect(const int *rects, size_t stride, size_t count,
+                           const int *rect)
+    {
+        const int rx1 = rect[0];
+        const int ry1 = rect[1];
+        const int rx2 = rect[0] + rect[2];
+        const int ry2 = rect[1] + rect[3];
+        unsigned char hit[INTERSECT_BLOCK];
+
+        for (size_t base = 0; base < count; base += INTERSECT_BLOCK) {
+            size_t n = count - base < INTERSECT_BLOCK ? count - base
+                                                      : INTERSECT_BLOCK;
+            unsigned char any = 0;
+
+            for (size_t i = 0; i < n; i++) {
+                const int *r = rects + (base + i) * stride;
+                int x1 = r[0] > rx1 ? r[0] : rx1;
+                int y1 = r[1] > ry1 ? r[1] : ry1;
+                int x2 = r[0] + r[2] < rx2 ? r[0] + r[2] : rx2;
+                int y2 = r[1] + r[3] < ry2 ? r[1] + r[3] : ry2;
+
+                hit[i] = (x1 < x2) & (y1 < y2);
+                any |= hit[i];
+            }
+
+            if (any) {
+                for (size_t i = 0; i < n; i++) {
+                    if (hit[i]) {
+                        return base + i;
+                    }
+                }
+            }
+        }
+
+        return count;
+    }
+
+    void classify_row(const unsigned char *pixels, unsigned char *out,
+                      size_t count, const uint32_t *tables,
+                      const uint32_t *pairs, uint32_t decisive,
+                      unsigned char fallback)
+    {
+        bool compare = false;
+
+        for (unsigned int k = 0; k < 6; k++) {
+            compare = compare || pairs[k] != 0;
+        }
+
+        /* everything is computed without branches, data dependent
+         * branches are mispredicted on every other pixel; the first rule
+         * left is the lowest bit and no rule left means fallback */
+        if (!compare) {
+            for (size_t i = 0; i < count; i++) {
+                const unsigned char *p = pixels + 3 * i;
+                uint32_t m = tables[p[0]] & tables[256 + p[1]]
+                             & tables[512 + p[2]];
+
+                out[i] = (unsigned char)(0u - ((m & (0u - m) & decisive) != 0))
+                         ^ fallback;
+            }
+
+            return;
+        }
+
+        /* the sign of b - a keeps rules of pair (a, b) where a > b */
+        for (size_t i = 0; i < count; i++) {
+            const unsigned char *p = pixels + 3 * i;
+            const int c0 = p[0];
+            const int c1 = p[1];
+            const int c2 = p[2];
+            uint32_t m = tables[c0] & tables[256 + c1] & tables[512 + c2];
+
+            m &= ~pairs[0] | (uint32_t)((c1 - c0) >> 31);
+            m &= ~pairs[1] | (uint32_t)((c2 - c0) >> 31);
+            m &= ~pairs[2] | (uint32_t)((c2 - c1) >> 31);
+            m &= ~pairs[3] | (uint32_t)((c0 - c1) >> 31);
+            m &= ~pairs[4] | (uint32_t)((c0 - c2) >> 31);
+            m &= ~pairs[5] | (uint32_t)((c1 - c2) >> 31);
+
+            out[i] = (unsigned char)(0u - ((m & (0u - m) & decisive) != 0))
+                     ^ fallback;
+        }
+    }
+}
+
+namespace ODF
+{
+    const Kernels ODF_KERNELS_TABLE = {
+        ODF_KERNELS_LEVEL,
+        fill_masked,
+        integral_row,
+        window_ratios,
+        first_intersect,
+        classify_row
+    };
+}
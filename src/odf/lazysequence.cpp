@@ -0,0 +1,226 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include <odf/lazysequence.h>
+
+using namespace ODF;
+
+LazyImageSequence::LazyImageSequence(const std::string &dirpath,
+                                     const std::string &extension,
+                                     const std::string &prefix,
+                                     const std::string &suffix,
+                                     unsigned short num_digits,
+                                     unsigned int range_start,
+                                     unsigned int range_end)
+    : type(NUMBERED),
+      dirpath(dirpath),
+      extension(extension),
+      prefix(prefix),
+      suffix(suffix),
+      num_digits(num_digits),
+      range_start(range_start),
+      range_end(range_end),
+      filenames()
+{
+    char last;
+
+    if (!this->dirpath.empty()) {
+        last = *(this->dirpath.rbegin());
+        if (last != '/' && last != '\\') {
+            this->dirpath.push_back('/');
+        }
+    }
+}
+
+LazyImageSequence::LazyImageSequence(const std::vector<std::string> &filenames)
+    : type(LIST),
+      num_digits(0),
+      range_start(0),
+      range_end(0),
+      filenames(filenames)
+{
+    /* noop */
+}
+
+LazyImageSequence LazyImageSequence::fromDirectory(const std::string &dirpath,
+                                                   const std::string &extension)
+{
+    std::vector<std::string> filenames;
+    std::string suffix = "." + extension;
+    std::string dir = dirpath;
+    std::string name;
+    struct dirent *entry;
+    struct stat st;
+    DIR *dp;
+
+    if (dir.empty()) {
+        dir = ".";
+    }
+
+    if (*(dir.rbegin()) != '/') {
+        dir.push_back('/');
+    }
+
+    dp = opendir(dir.c_str());
+    if (dp == NULL) {
+        throw std::runtime_error("Unable to read directory " + dirpath + ": "
+                                 + strerror(errno));
+    }
+
+    while ((entry = readdir(dp)) != NULL) {
+        name = entry->d_name;
+
+        if (!extension.empty()
+                && (name.length() <= suffix.length()
+                    || name.compare(name.length() - suffix.length(),
+                                    suffix.length(), suffix) != 0)) {
+            continue;
+        }
+
+        if (stat((dir + name).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+
+        filenames.push_back(dir + name);
+    }
+
+    closedir(dp);
+
+    std::sort(filenames.begin(), filenames.end());
+
+    return LazyImageSequence(filenames);
+}
+
+/* frees glob() result on every path, glob() may allocate even on error */
+class GlobResult
+{
+public:
+    glob_t result;
+
+    GlobResult()
+    {
+        memset(&this->result, 0, sizeof(glob_t));
+    }
+
+    ~GlobResult()
+    {
+        globfree(&this->result);
+    }
+
+private:
+    GlobResult(const GlobResult &);
+    GlobResult & operator=(const GlobResult &);
+};
+
+LazyImageSequence LazyImageSequence::fromGlob(const std::string &pattern)
+{
+    std::vector<std::string> filenames;
+    GlobResult glob_result;
+    glob_t &result = glob_result.result;
+    int ret;
+
+    ret = glob(pattern.c_str(), 0, NULL, &result);
+    switch (ret) {
+    case 0:
+        break;
+    case GLOB_NOMATCH:
+        return LazyImageSequence(filenames);
+    default:
+        throw std::runtime_error("Unable to expand pattern " + pattern);
+    }
+
+    /* glob() already sorts the names */
+    for (size_t i = 0; i < result.gl_pathc; i++) {
+        filenames.push_back(result.gl_pathv[i]);
+    }
+
+    return LazyImageSequence(filenames);
+}
+
+size_t LazyImageSequence::size() const
+{
+    if (this->type == LIST) {
+        return this->filenames.size();
+    }
+
+    if (this->range_end < this->range_start) {
+        return 0;
+    }
+
+    return (size_t)this->range_end - this->range_start + 1;
+}
+
+bool LazyImageSequence::empty() const
+{
+    return this->size() == 0;
+}
+
+std::string LazyImageSequence::getFilename(size_t index) const
+{
+    char number[32];
+
+    if (index >= this->size()) {
+        throw std::out_of_range("Image index is out of range");
+    }
+
+    if (this->type == LIST) {
+        return this->filenames[index];
+    }
+
+    snprintf(number, sizeof(number), "%0*u", (int)this->num_digits,
+             (unsigned int)(this->range_start + index));
+
+    return this->dirpath + this->prefix + number + this->suffix
+           + '.' + this->extension;
+}
+
+Image LazyImageSequence::operator[](size_t index) const
+{
+    return Image(this->getFilename(index));
+}
+
+LazyImageSequence::Accessor::Accessor(const LazyImageSequence *sequence)
+    : sequence(sequence)
+{
+    /* noop */
+}
+
+size_t LazyImageSequence::Accessor::size() const
+{
+    return this->sequence->size();
+}
+
+Image *LazyImageSequence::Accessor::operator()(size_t index,
+                                               std::unique_ptr<Image> &storage) const
+{
+    storage.reset(new Image(this->sequence->getFilename(index)));
+
+    return storage.get();
+}
@@ -0,0 +1,278 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <fstream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <odf/metrics.h>
+
+using namespace ODF;
+
+namespace
+{
+    /**
+     * Counters of one thread. Only the owning thread writes them, other
+     * threads may read them at any time.
+     */
+    struct MetricsBlock
+    {
+        std::atomic<uint64_t> values[Metrics::NumCounters];
+
+        MetricsBlock()
+        {
+            for (int i = 0; i < Metrics::NumCounters; i++) {
+                this->values[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    struct MetricsRegistry
+    {
+        std::mutex lock;
+        std::vector<MetricsBlock*> blocks;
+    };
+
+    MetricsRegistry & registry()
+    {
+        /* blocks outlive their threads, the registry is never freed */
+        static MetricsRegistry *reg = new MetricsRegistry();
+        return *reg;
+    }
+
+    MetricsBlock * local_block()
+    {
+        static thread_local MetricsBlock *block = NULL;
+
+        if (block == NULL) {
+            MetricsRegistry &reg = registry();
+            std::lock_guard<std::mutex> guard(reg.lock);
+
+            block = new MetricsBlock();
+            reg.blocks.push_back(block);
+        }
+
+        return block;
+    }
+
+    const char *names[Metrics::NumCounters] = {
+        "pixels_thresholded",
+        "pixels_masked",
+        "functor_calls",
+        "windows_evaluated",
+        "windows_accepted",
+        "box_merges",
+        "bytes_allocated",
+        "decode_bytes",
+        "encode_bytes"
+    };
+
+    const char *help[Metrics::NumCounters] = {
+        "Pixels decided by threshold.",
+        "Pixels decided by the foreground mask without calling the functor.",
+        "Threshold functor invocations.",
+        "Sliding window positions tested.",
+        "Sliding windows above the fill ratio threshold.",
+        "Windows and boxes merged into an existing bounding box.",
+        "Bytes of image buffers allocated by processing stages.",
+        "Bytes of pixel data produced by image and video decoding.",
+        "Bytes of pixel data passed to image encoding."
+    };
+}
+
+void Metrics::add(Counter counter, uint64_t value)
+{
+    std::atomic<uint64_t> &slot = local_block()->values[counter];
+
+    /* single writer, no need for read-modify-write */
+    slot.store(slot.load(std::memory_order_relaxed) + value,
+               std::memory_order_relaxed);
+}
+
+uint64_t Metrics::get(Counter counter)
+{
+    return Metrics::total().get(counter);
+}
+
+FrameStats Metrics::total()
+{
+    MetricsRegistry &reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    FrameStats stats;
+
+    for (size_t i = 0; i < reg.blocks.size(); i++) {
+        for (int j = 0; j < NumCounters; j++) {
+            Counter counter = static_cast<Counter>(j);
+            stats.set(counter, stats.get(counter)
+                      + reg.blocks[i]->values[j].load(std::memory_order_relaxed));
+        }
+    }
+
+    return stats;
+}
+
+FrameStats Metrics::local()
+{
+    MetricsBlock *block = local_block();
+    FrameStats stats;
+
+    for (int i = 0; i < NumCounters; i++) {
+        stats.set(static_cast<Counter>(i),
+                  block->values[i].load(std::memory_order_relaxed));
+    }
+
+    return stats;
+}
+
+const char * Metrics::getName(Counter counter)
+{
+    return names[counter];
+}
+
+const char * Metrics::getHelp(Counter counter)
+{
+    return help[counter];
+}
+
+void Metrics::writePrometheus(std::ostream &stream)
+{
+    FrameStats stats = Metrics::total();
+
+    for (int i = 0; i < NumCounters; i++) {
+        Counter counter = static_cast<Counter>(i);
+
+        stream << "# HELP odf_" << names[i] << "_total " << help[i] << "\n"
+               << "# TYPE odf_" << names[i] << "_total counter\n"
+               << "odf_" << names[i] << "_total " << stats.get(counter)
+               << "\n";
+    }
+}
+
+bool Metrics::dumpPrometheus(const std::string &filename)
+{
+    std::string tmp = filename + ".tmp";
+    std::ofstream file(tmp.c_str());
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    Metrics::writePrometheus(file);
+    file.close();
+    if (file.fail()) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+    return std::rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+FrameStats::FrameStats()
+{
+    for (int i = 0; i < Metrics::NumCounters; i++) {
+        this->values[i] = 0;
+    }
+}
+
+uint64_t FrameStats::get(Metrics::Counter counter) const
+{
+    return this->values[counter];
+}
+
+void FrameStats::set(Metrics::Counter counter, uint64_t value)
+{
+    this->values[counter] = value;
+}
+
+FrameStats & FrameStats::operator+=(const FrameStats &other)
+{
+    for (int i = 0; i < Metrics::NumCounters; i++) {
+        this->values[i] += other.values[i];
+    }
+
+    return *this;
+}
+
+FrameStats & FrameStats::operator-=(const FrameStats &other)
+{
+    for (int i = 0; i < Metrics::NumCounters; i++) {
+        this->values[i] -= other.values[i];
+    }
+
+    return *this;
+}
+
+FrameStats FrameStats::operator-(const FrameStats &other) const
+{
+    FrameStats result = *this;
+    result -= other;
+    return result;
+}
+
+MetricsScope::MetricsScope(FrameStats &stats)
+    : stats(stats),
+      start(Metrics::local())
+{
+    /* noop */
+}
+
+MetricsScope::~MetricsScope()
+{
+    this->stats += Metrics::local() - this->start;
+}
+
+MetricsExporter::MetricsExporter(const std::string &filename,
+                                 unsigned int interval)
+    : filename(filename),
+      interval(interval),
+      stopping(false)
+{
+    this->thread = std::thread(&MetricsExporter::run, this);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+
+    this->cond.notify_all();
+    this->thread.join();
+
+    Metrics::dumpPrometheus(this->filename);
+}
+
+void MetricsExporter::run()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    std::chrono::milliseconds period(this->interval);
+
+    while (!this->cond.wait_for(lock, period,
+                                [this] { return this->stopping; })) {
+        lock.unlock();
+        Metrics::dumpPrometheus(this->filename);
+        lock.lock();
+    }
+}
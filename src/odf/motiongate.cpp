@@ -0,0 +1,108 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdexcept>
+#include <odf/motiongate.h>
+
+using namespace ODF;
+
+MotionGate::MotionGate(unsigned int block_size,
+                       unsigned int subsample,
+                       double threshold)
+    : block_size(block_size),
+      subsample(subsample),
+      threshold(threshold)
+{
+    if (subsample == 0 || block_size == 0 || block_size % subsample != 0) {
+        throw std::logic_error("Block size must be a multiple of subsample");
+    }
+}
+
+MotionGate::Result MotionGate::check(const cv::Mat &frame)
+{
+    cv::Size grid(std::max(frame.cols / (int)this->subsample, 1),
+                  std::max(frame.rows / (int)this->subsample, 1));
+    int cells = this->block_size / this->subsample;
+    cv::Size nblocks((grid.width + cells - 1) / cells,
+                     (grid.height + cells - 1) / cells);
+    cv::Point tl(nblocks.width, nblocks.height);
+    cv::Point br(-1, -1);
+    cv::Mat small;
+    Result result;
+
+    /* nearest neighbour takes only the sampled pixels */
+    cv::resize(frame, small, grid, 0, 0, cv::INTER_NEAREST);
+    if (small.channels() == 3) {
+        cv::cvtColor(small, this->current, cv::COLOR_BGR2GRAY);
+    } else {
+        this->current = small;
+    }
+
+    result.changed = 0;
+
+    if (this->reference.size() != this->current.size()) {
+        this->current.copyTo(this->reference);
+        result.motion = true;
+        result.roi = cv::Rect(0, 0, frame.cols, frame.rows);
+        return result;
+    }
+
+    /* mean absolute difference of each block */
+    cv::absdiff(this->current, this->reference, this->diff);
+    cv::resize(this->diff, this->blocks, nblocks, 0, 0, cv::INTER_AREA);
+
+    for (int y = 0; y < this->blocks.rows; y++) {
+        const uchar *row = this->blocks.ptr<uchar>(y);
+
+        for (int x = 0; x < this->blocks.cols; x++) {
+            if (row[x] > this->threshold) {
+                tl.x = std::min(tl.x, x);
+                tl.y = std::min(tl.y, y);
+                br.x = std::max(br.x, x);
+                br.y = std::max(br.y, y);
+                result.changed++;
+            }
+        }
+    }
+
+    result.motion = result.changed != 0;
+    if (!result.motion) {
+        return result;
+    }
+
+    /* moving objects usually reach into the neighbouring blocks */
+    result.roi = cv::Rect((tl.x - 1) * this->block_size,
+                          (tl.y - 1) * this->block_size,
+                          (br.x - tl.x + 3) * this->block_size,
+                          (br.y - tl.y + 3) * this->block_size);
+    result.roi &= cv::Rect(0, 0, frame.cols, frame.rows);
+
+    std::swap(this->reference, this->current);
+
+    return result;
+}
+
+void MotionGate::reset()
+{
+    this->reference.release();
+}
@@ -0,0 +1,386 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <unistd.h>
+#include <odf/resultcache.h>
+
+#define ODF_RESULTCACHE_MAGIC "ODFCACHE"
+#define ODF_RESULTCACHE_VERSION 1
+
+#define PRIME1 0x9e3779b185ebca87ULL
+#define PRIME2 0xc2b2ae3d27d4eb4fULL
+#define PRIME3 0x165667b19e3779f9ULL
+
+using namespace ODF;
+
+static inline uint64_t rotl(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t mix(uint64_t h, uint64_t k)
+{
+    k *= PRIME2;
+    k = rotl(k, 31);
+    k *= PRIME1;
+    h ^= k;
+    return rotl(h, 27) * PRIME1 + PRIME3;
+}
+
+static inline uint64_t finalize(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+template <typename T>
+static void put(std::ostream &out, T value)
+{
+    out.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+static bool get(std::istream &in, T *value)
+{
+    return (bool)in.read((char*)value, sizeof(T));
+}
+
+bool ResultCache::Key::operator==(const Key &other) const
+{
+    return this->content == other.content && this->params == other.params;
+}
+
+size_t ResultCache::KeyHash::operator()(const Key &key) const
+{
+    return key.content ^ rotl(key.params, 17);
+}
+
+ResultCache::ResultCache(size_t capacity, const std::string &directory)
+    : capacity(capacity),
+      directory(directory),
+      written(0)
+{
+    memset(&this->stats, 0, sizeof(Statistics));
+}
+
+bool ResultCache::lookup(uint64_t content, uint64_t params,
+                         cv::Mat *mask, BoundingBoxVector *objects)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    EntryMap::iterator it;
+    Entry entry;
+    Key key;
+
+    key.content = content;
+    key.params = params;
+
+    it = this->map.find(key);
+    if (it != this->map.end()) {
+        /* move to front */
+        this->entries.splice(this->entries.begin(), this->entries, it->second);
+        this->stats.hits++;
+        entry = this->entries.front();
+    } else {
+        /* other threads may use the memory cache meanwhile */
+        lock.unlock();
+        if (!this->readEntry(key, &entry)) {
+            lock.lock();
+            this->stats.misses++;
+            return false;
+        }
+
+        lock.lock();
+        if (this->map.find(key) == this->map.end()) {
+            this->insert(entry);
+        }
+        this->stats.disk_hits++;
+    }
+
+    if (mask != NULL) {
+        *mask = entry.mask;
+    }
+
+    if (objects != NULL) {
+        *objects = entry.objects;
+    }
+
+    return true;
+}
+
+void ResultCache::store(uint64_t content, uint64_t params,
+                        const cv::Mat &mask, const BoundingBoxVector &objects)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    EntryMap::iterator it;
+    Entry entry;
+
+    entry.key.content = content;
+    entry.key.params = params;
+    entry.mask = mask;
+    entry.objects = objects;
+
+    it = this->map.find(entry.key);
+    if (it != this->map.end()) {
+        this->entries.erase(it->second);
+        this->map.erase(it);
+    }
+
+    this->insert(entry);
+    lock.unlock();
+
+    /* encoding and disk I/O must not block other threads */
+    if (!this->writeEntry(entry)) {
+        lock.lock();
+        this->stats.write_failures++;
+    }
+}
+
+ResultCache::Statistics ResultCache::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->stats;
+}
+
+uint64_t ResultCache::hash(const void *data, size_t length, uint64_t seed)
+{
+    const uchar *bytes = (const uchar*)data;
+    uint64_t h = seed + PRIME3 + length;
+    uint64_t k;
+    size_t i;
+
+    for (i = 0; i + 8 <= length; i += 8) {
+        memcpy(&k, bytes + i, 8);
+        h = mix(h, k);
+    }
+
+    if (i < length) {
+        k = 0;
+        memcpy(&k, bytes + i, length - i);
+        h = mix(h, k);
+    }
+
+    return finalize(h);
+}
+
+uint64_t ResultCache::hash(const cv::Mat &matrix, uint64_t seed)
+{
+    int32_t header[3] = {matrix.rows, matrix.cols, matrix.type()};
+    size_t row_length = matrix.cols * matrix.elemSize();
+    uint64_t h;
+
+    h = ResultCache::hash(header, sizeof(header), seed);
+    if (matrix.isContinuous()) {
+        return ResultCache::hash(matrix.data, row_length * matrix.rows, h);
+    }
+
+    for (int i = 0; i < matrix.rows; i++) {
+        h = ResultCache::hash(matrix.ptr(i), row_length, h);
+    }
+
+    return h;
+}
+
+uint64_t ResultCache::hash(const std::string &value, uint64_t seed)
+{
+    return ResultCache::hash(value.data(), value.length(), seed);
+}
+
+uint64_t ResultCache::hashFile(const std::string &filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    std::vector<char> buffer(1 << 16);
+    uint64_t h = 0;
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to read " + filename);
+    }
+
+    while (file.read(&buffer[0], buffer.size()) || file.gcount() > 0) {
+        h = ResultCache::hash(&buffer[0], file.gcount(), h);
+    }
+
+    if (file.bad()) {
+        throw std::runtime_error("Unable to read " + filename);
+    }
+
+    return h;
+}
+
+void ResultCache::insert(const Entry &entry)
+{
+    this->entries.push_front(entry);
+    this->map[entry.key] = this->entries.begin();
+
+    while (this->entries.size() > this->capacity) {
+        this->map.erase(this->entries.back().key);
+        this->entries.pop_back();
+        this->stats.evictions++;
+    }
+}
+
+std::string ResultCache::entryFilename(const Key &key) const
+{
+    std::ostringstream name;
+
+    name << this->directory << "/" << std::hex << std::setfill('0')
+         << std::setw(16) << key.content << "-"
+         << std::setw(16) << key.params << ".odfc";
+
+    return name.str();
+}
+
+bool ResultCache::readEntry(const Key &key, Entry *entry) const
+{
+    std::ifstream file;
+    std::vector<uchar> png;
+    char magic[8];
+    uint32_t version;
+    uint32_t length;
+    uint32_t count;
+    int32_t rect[8];
+    double fill_ratio;
+
+    if (this->directory.empty()) {
+        return false;
+    }
+
+    file.open(this->entryFilename(key).c_str(),
+              std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    if (!file.read(magic, 8) || memcmp(magic, ODF_RESULTCACHE_MAGIC, 8) != 0
+            || !get(file, &version) || version != ODF_RESULTCACHE_VERSION
+            || !get(file, &length)) {
+        return false;
+    }
+
+    entry->key = key;
+    entry->mask.release();
+    if (length != 0) {
+        png.resize(length);
+        if (!file.read((char*)&png[0], length)) {
+            return false;
+        }
+
+        entry->mask = cv::imdecode(cv::Mat(png), 0);
+        if (entry->mask.empty()) {
+            return false;
+        }
+    }
+
+    if (!get(file, &count)) {
+        return false;
+    }
+
+    entry->objects = BoundingBoxVector();
+    for (uint32_t i = 0; i < count; i++) {
+        if (!file.read((char*)rect, sizeof(rect))
+                || !get(file, &fill_ratio)) {
+            return false;
+        }
+
+        /* best fit box first, the bounding box contains it */
+        BoundingBox box(cv::Rect(rect[4], rect[5], rect[6], rect[7]),
+                        fill_ratio);
+        box.expand(cv::Rect(rect[0], rect[1], rect[2], rect[3]));
+        entry->objects.append(box);
+    }
+
+    return true;
+}
+
+bool ResultCache::writeEntry(const Entry &entry)
+{
+    BoundingBoxVector::const_iterator it;
+    std::ostringstream name;
+    std::string filename;
+    std::string tmp;
+    std::ofstream file;
+    std::vector<uchar> png;
+    cv::Rect box;
+    cv::Rect best;
+
+    if (this->directory.empty()) {
+        return true;
+    }
+
+    /* binary masks compress very well */
+    if (!entry.mask.empty() && !cv::imencode(".png", entry.mask, png)) {
+        return false;
+    }
+
+    /* several threads or processes may store the same frame */
+    filename = this->entryFilename(entry.key);
+    name << filename << "." << getpid() << "-" << this->written++ << ".tmp";
+    tmp = name.str();
+    file.open(tmp.c_str(), std::ios::out | std::ios::binary
+                           | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.write(ODF_RESULTCACHE_MAGIC, 8);
+    put<uint32_t>(file, ODF_RESULTCACHE_VERSION);
+    put<uint32_t>(file, png.size());
+    if (!png.empty()) {
+        file.write((const char*)&png[0], png.size());
+    }
+
+    put<uint32_t>(file, entry.objects.size());
+    for (it = entry.objects.begin(); it != entry.objects.end(); it++) {
+        box = it->getBoundingBox();
+        best = it->getBestFitBox();
+
+        put<int32_t>(file, box.x);
+        put<int32_t>(file, box.y);
+        put<int32_t>(file, box.width);
+        put<int32_t>(file, box.height);
+        put<int32_t>(file, best.x);
+        put<int32_t>(file, best.y);
+        put<int32_t>(file, best.width);
+        put<int32_t>(file, best.height);
+        put<double>(file, it->getFillRatio());
+    }
+
+    file.close();
+    if (file.fail() || rename(tmp.c_str(), filename.c_str()) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,236 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <odf/roi.h>
+
+using namespace ODF;
+
+RegionOfInterest::RegionOfInterest(const cv::Mat &mask)
+{
+    if (mask.type() != CV_8U) {
+        throw std::logic_error("Mask is not of CV_8U type");
+    }
+
+    cv::threshold(mask, this->mask, 0, 255, cv::THRESH_BINARY);
+    this->build();
+}
+
+RegionOfInterest::RegionOfInterest(const std::vector<cv::Rect> &rects,
+                                   const cv::Size &size)
+    : mask(cv::Mat::zeros(size.height, size.width, CV_8U))
+{
+    cv::Rect image(0, 0, size.width, size.height);
+    cv::Mat part;
+
+    for (size_t i = 0; i < rects.size(); i++) {
+        part = this->mask(rects[i] & image);
+        part.setTo(255);
+    }
+
+    this->build();
+}
+
+RegionOfInterest::RegionOfInterest(const std::vector<std::vector<cv::Point> > &polygons,
+                                   const cv::Size &size)
+    : mask(cv::Mat::zeros(size.height, size.width, CV_8U))
+{
+    const cv::Point *points;
+    int num_points;
+
+    for (size_t i = 0; i < polygons.size(); i++) {
+        if (polygons[i].empty()) {
+            continue;
+        }
+
+        points = &polygons[i][0];
+        num_points = polygons[i].size();
+        cv::fillPoly(this->mask, &points, &num_points, 1, cv::Scalar(255));
+    }
+
+    this->build();
+}
+
+RegionOfInterest RegionOfInterest::load(const std::string &filename,
+                                        const cv::Size &size)
+{
+    static const char *images[] = {".png", ".bmp", ".pgm", ".jpg", ".tif"};
+    std::vector<std::vector<cv::Point> > polygons;
+    std::vector<cv::Rect> rects;
+    std::string line;
+    std::string type;
+    std::ifstream file;
+    cv::Mat mask;
+    cv::Point point;
+    cv::Rect rect;
+    size_t dot;
+    unsigned int num_line = 0;
+
+    dot = filename.rfind('.');
+    for (size_t i = 0; dot != std::string::npos && i < 5; i++) {
+        if (filename.compare(dot, std::string::npos, images[i]) != 0) {
+            continue;
+        }
+
+        mask = cv::imread(filename, 0);
+        if (mask.data == NULL) {
+            throw std::runtime_error("Unable to read " + filename);
+        }
+
+        if (mask.cols != size.width || mask.rows != size.height) {
+            cv::resize(mask, mask, size, 0, 0, cv::INTER_NEAREST);
+        }
+
+        return RegionOfInterest(mask);
+    }
+
+    file.open(filename.c_str());
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to read " + filename);
+    }
+
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+
+        num_line++;
+        if (!(ss >> type) || type[0] == '#') {
+            continue;
+        }
+
+        if (type == "rect" && ss >> rect.x >> rect.y >> rect.width
+                                 >> rect.height) {
+            rects.push_back(rect);
+        } else if (type == "polygon") {
+            polygons.push_back(std::vector<cv::Point>());
+            while (ss >> point.x >> point.y) {
+                polygons.back().push_back(point);
+            }
+
+            if (polygons.back().size() < 3) {
+                type.clear();
+            }
+        } else {
+            type.clear();
+        }
+
+        if (type.empty()) {
+            std::ostringstream error;
+            error << "Invalid region on line " << num_line << " of "
+                  << filename;
+            throw std::runtime_error(error.str());
+        }
+    }
+
+    /* rasterize both shapes into one mask */
+    RegionOfInterest roi(polygons, size);
+    cv::Rect image(0, 0, size.width, size.height);
+    cv::Mat part;
+
+    for (size_t i = 0; i < rects.size(); i++) {
+        part = roi.mask(rects[i] & image);
+        part.setTo(255);
+    }
+
+    roi.build();
+
+    return roi;
+}
+
+cv::Size RegionOfInterest::getSize() const
+{
+    return cv::Size(this->mask.cols, this->mask.rows);
+}
+
+const cv::Rect & RegionOfInterest::getBoundingRect() const
+{
+    return this->bounding_rect;
+}
+
+const cv::Mat & RegionOfInterest::getMask() const
+{
+    return this->mask;
+}
+
+const std::vector<RegionOfInterest::Span> &
+RegionOfInterest::getSpans(int row) const
+{
+    return this->spans[row];
+}
+
+bool RegionOfInterest::intersects(const cv::Rect &rect) const
+{
+    cv::Rect r = rect & cv::Rect(0, 0, this->mask.cols, this->mask.rows);
+    int sum;
+
+    if (r.area() == 0) {
+        return false;
+    }
+
+    sum = this->sat.at<int>(r.y + r.height, r.x + r.width)
+          - this->sat.at<int>(r.y + r.height, r.x)
+          - this->sat.at<int>(r.y, r.x + r.width)
+          + this->sat.at<int>(r.y, r.x);
+
+    return sum > 0;
+}
+
+unsigned int RegionOfInterest::area() const
+{
+    return this->sat.at<int>(this->mask.rows, this->mask.cols);
+}
+
+void RegionOfInterest::build()
+{
+    cv::Point tl(this->mask.cols, this->mask.rows);
+    cv::Point br(0, 0);
+    int start;
+
+    cv::integral(this->mask / 255, this->sat);
+
+    this->spans.assign(this->mask.rows, std::vector<Span>());
+    for (int y = 0; y < this->mask.rows; y++) {
+        const uchar *row = this->mask.ptr<uchar>(y);
+
+        for (int x = 0; x < this->mask.cols; x++) {
+            if (row[x] == 0) {
+                continue;
+            }
+
+            start = x;
+            while (x < this->mask.cols && row[x] != 0) {
+                x++;
+            }
+
+            this->spans[y].push_back(Span(start, x));
+            tl.x = std::min(tl.x, start);
+            tl.y = std::min(tl.y, y);
+            br.x = std::max(br.x, x);
+            br.y = std::max(br.y, y + 1);
+        }
+    }
+
+    this->bounding_rect = br.x > tl.x ? cv::Rect(tl, br) : cv::Rect();
+}
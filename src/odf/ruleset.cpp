@@ -0,0 +1,684 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+#include <odf/ruleset.h>
+#include <odf/image.h>
+
+using namespace ODF;
+
+static void check_channel(unsigned int channel)
+{
+    if (channel > 2) {
+        throw std::logic_error("Rule channel must be 0, 1 or 2!");
+    }
+}
+
+ColorRule::ColorRule(bool accept /*= true*/,
+                     const std::string &name /*= ""*/)
+    : num_tests(0),
+      accept(accept),
+      name(name)
+{
+    for (unsigned int c = 0; c < 3; c++) {
+        std::fill(this->bits[c], this->bits[c] + 4, ~(uint64_t)0);
+        this->restricted[c] = false;
+        this->order[c] = c;
+    }
+}
+
+ColorRule & ColorRule::range(unsigned int channel, double min, double max)
+{
+    check_channel(channel);
+
+    /* the same rounding as thresholds written by hand use */
+    double low = std::max(0.0, std::floor(min));
+    double high = std::min(255.0, std::ceil(max));
+
+    if (!this->restricted[channel]) {
+        std::fill(this->bits[channel], this->bits[channel] + 4, 0);
+        this->restricted[channel] = true;
+        this->order[this->num_tests++] = channel;
+    }
+
+    for (int v = (int)low; v <= (int)high; v++) {
+        this->bits[channel][v >> 6] |= (uint64_t)1 << (v & 63);
+    }
+
+    return *this;
+}
+
+ColorRule & ColorRule::atLeast(unsigned int channel, double min)
+{
+    return this->range(channel, min, 255);
+}
+
+ColorRule & ColorRule::greater(unsigned int channel, unsigned int other)
+{
+    check_channel(channel);
+    check_channel(other);
+
+    this->comparisons.push_back(std::make_pair(channel, other));
+
+    return *this;
+}
+
+bool ColorRule::overlaps(const ColorRule &other) const
+{
+    for (unsigned int c = 0; c < 3; c++) {
+        uint64_t common = 0;
+
+        for (unsigned int w = 0; w < 4; w++) {
+            common |= this->bits[c][w] & other.bits[c][w];
+        }
+
+        if (common == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ColorRule::isRestricted(unsigned int channel) const
+{
+    check_channel(channel);
+
+    return this->restricted[channel];
+}
+
+const std::vector<std::pair<unsigned int, unsigned int> > &
+ColorRule::getComparisons() const
+{
+    return this->comparisons;
+}
+
+bool ColorRule::accepts() const
+{
+    return this->accept;
+}
+
+const std::string & ColorRule::getName() const
+{
+    return this->name;
+}
+
+RuleSet::RuleSet(bool fallback /*= false*/,
+                 unsigned int conversion /*= cv::COLOR_COLORCVT_MAX*/)
+    : fallback(fallback),
+      conversion(conversion)
+{
+    this->build(NULL);
+}
+
+/* colour spaces of rule files */
+enum space_index {SPACE_RGB, SPACE_HSV, SPACE_YCRCB, NUM_SPACES};
+
+static const char *space_names[NUM_SPACES] = {"rgb", "hsv", "ycrcb"};
+
+static const unsigned int space_conversions[NUM_SPACES] = {
+    cv::COLOR_COLORCVT_MAX, cv::COLOR_BGR2HSV, cv::COLOR_BGR2YCrCb
+};
+
+/* channel names in cv::Vec3b order */
+static const char *channel_names[NUM_SPACES][3] = {
+    {"blue", "green", "red"},
+    {"hue", "sat", "val"},
+    {"y", "cr", "cb"}
+};
+
+static int find_channel(int space, const std::string &name)
+{
+    for (int c = 0; c < 3; c++) {
+        if (name == channel_names[space][c]) {
+            return c;
+        }
+    }
+
+    return -1;
+}
+
+/* rule file units to channel values */
+static double convert_unit(int space, int channel, double value)
+{
+    if (space != SPACE_HSV) {
+        return value;
+    }
+
+    switch (channel) {
+    case HUE:
+        return ODF_CONV_HUE(value);
+    case SAT:
+        return ODF_CONV_SAT(value);
+    default:
+        return ODF_CONV_VAL(value);
+    }
+}
+
+static bool parse_number(const std::string &token, double *value)
+{
+    char *end = NULL;
+
+    *value = strtod(token.c_str(), &end);
+
+    return !token.empty() && *end == '\0';
+}
+
+static bool parse_rule(const std::vector<std::string> &tokens, int space,
+                       ColorRule *rule)
+{
+    size_t i = 2;
+
+    *rule = ColorRule(tokens[0] == "accept", tokens[1]);
+
+    while (i < tokens.size()) {
+        size_t gt = tokens[i].find('>');
+        int channel;
+        double min;
+        double max;
+        unsigned int ranges = 0;
+
+        if (gt != std::string::npos) {
+            int a = find_channel(space, tokens[i].substr(0, gt));
+            int b = find_channel(space, tokens[i].substr(gt + 1));
+
+            if (a < 0 || b < 0) {
+                return false;
+            }
+
+            rule->greater(a, b);
+            i++;
+            continue;
+        }
+
+        channel = find_channel(space, tokens[i++]);
+        if (channel < 0) {
+            return false;
+        }
+
+        while (i + 1 < tokens.size() && parse_number(tokens[i], &min)
+                   && parse_number(tokens[i + 1], &max)) {
+            rule->range(channel, convert_unit(space, channel, min),
+                        convert_unit(space, channel, max));
+            ranges++;
+            i += 2;
+        }
+
+        /* a lone number is a half of a range */
+        if (ranges == 0 || (i < tokens.size()
+                            && parse_number(tokens[i], &min))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+RuleSet RuleSet::load(const std::string &filename)
+{
+    std::ifstream file;
+
+    file.open(filename.c_str());
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to read " + filename);
+    }
+
+    return RuleSet::parse(file, filename);
+}
+
+RuleSet RuleSet::parse(std::istream &in, const std::string &name)
+{
+    std::vector<ColorRule> rules;
+    std::vector<std::string> tokens;
+    std::string line;
+    std::string token;
+    ColorRule rule;
+    int space = SPACE_RGB;
+    bool fallback = false;
+    bool valid;
+    unsigned int num_line = 0;
+
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+
+        num_line++;
+        tokens.clear();
+        while (ss >> token) {
+            tokens.push_back(token);
+        }
+
+        if (tokens.empty() || tokens[0][0] == '#') {
+            continue;
+        }
+
+        valid = false;
+        if (tokens[0] == "space" && tokens.size() == 2 && rules.empty()) {
+            for (int i = 0; i < NUM_SPACES; i++) {
+                if (tokens[1] == space_names[i]) {
+                    space = i;
+                    valid = true;
+                }
+            }
+        } else if (tokens[0] == "fallback" && tokens.size() == 2) {
+            valid = tokens[1] == "accept" || tokens[1] == "reject";
+            fallback = tokens[1] == "accept";
+        } else if ((tokens[0] == "accept" || tokens[0] == "reject")
+                       && tokens.size() >= 3) {
+            valid = parse_rule(tokens, space, &rule);
+            rules.push_back(rule);
+        }
+
+        if (!valid) {
+            std::ostringstream error;
+            error << "Invalid rule on line " << num_line << " of "
+                  << name;
+            throw std::runtime_error(error.str());
+        }
+    }
+
+    RuleSet set(fallback, space_conversions[space]);
+    for (size_t i = 0; i < rules.size(); i++) {
+        set.add(rules[i]);
+    }
+
+    return set;
+}
+
+RuleSet & RuleSet::add(const ColorRule &rule)
+{
+    this->rules.push_back(rule);
+    this->build(NULL);
+
+    return *this;
+}
+
+size_t RuleSet::size() const
+{
+    return this->rules.size();
+}
+
+const ColorRule & RuleSet::operator[](size_t index) const
+{
+    return this->rules[index];
+}
+
+bool RuleSet::getFallback() const
+{
+    return this->fallback;
+}
+
+unsigned int RuleSet::getConversion() const
+{
+    return this->conversion;
+}
+
+unsigned int RuleSet::countTests(const cv::Vec3b &value) const
+{
+    unsigned int tests = 0;
+
+    for (unsigned int k = 0; k < this->num_checks; k++) {
+        tests++;
+        if (!this->reaches(this->checks[k], value[this->checks[k]])) {
+            return tests;
+        }
+    }
+
+    for (size_t i = 0; i < this->rules.size(); i++) {
+        const ColorRule &rule = this->rules[i];
+        bool matched = true;
+
+        for (unsigned int k = 0; matched && k < rule.num_tests; k++) {
+            tests++;
+            matched = rule.allows(rule.order[k], value[rule.order[k]]);
+        }
+
+        for (size_t k = 0; matched && k < rule.comparisons.size(); k++) {
+            tests++;
+            matched = value[rule.comparisons[k].first]
+                      > value[rule.comparisons[k].second];
+        }
+
+        if (matched) {
+            break;
+        }
+    }
+
+    return tests;
+}
+
+RuleSet RuleSet::optimize(const RuleProfile &profile) const
+{
+    const size_t n = this->rules.size();
+    std::vector<ColorRule> sorted(this->rules);
+    std::vector<double> cost(n);
+    std::vector<double> rate(n);
+    std::vector<bool> keep(n);
+    std::vector<bool> placed(n, false);
+    unsigned int order[3] = {0, 1, 2};
+    RuleSet optimized(this->fallback, this->conversion);
+    size_t remaining = 0;
+
+    if (profile.rules.size() != n) {
+        throw std::logic_error("Profile does not belong to the rule set!");
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        ColorRule &rule = sorted[i];
+        double pass = 1.0;
+
+        /* the test that rejects most goes first */
+        std::stable_sort(rule.order, rule.order + rule.num_tests,
+            [&profile, i](unsigned int a, unsigned int b) {
+                return profile.getRejectRate(i, a)
+                       > profile.getRejectRate(i, b);
+            });
+
+        /* expected number of tests, as if they were independent */
+        cost[i] = 0.0;
+        for (unsigned int k = 0; k < rule.num_tests; k++) {
+            cost[i] += pass;
+            pass *= 1.0 - profile.getRejectRate(i, rule.order[k]);
+        }
+        cost[i] += pass * rule.comparisons.size();
+        rate[i] = profile.getMatchRate(i);
+
+        /* rules with the fallback result matter only as a shield */
+        keep[i] = rule.accept != this->fallback;
+        for (size_t j = i + 1; !keep[i] && j < n; j++) {
+            keep[i] = this->rules[j].accept != this->fallback
+                      && rule.overlaps(this->rules[j]);
+        }
+
+        if (keep[i]) {
+            remaining++;
+        }
+    }
+
+    /* greedy order by match rate per test, rules with different result
+     * that may match the same pixel keep their order */
+    for (; remaining > 0; remaining--) {
+        size_t best = n;
+
+        for (size_t i = 0; i < n; i++) {
+            bool ready = keep[i] && !placed[i];
+
+            for (size_t j = 0; ready && j < i; j++) {
+                ready = !keep[j] || placed[j]
+                        || sorted[j].accept == sorted[i].accept
+                        || !sorted[j].overlaps(sorted[i]);
+            }
+
+            if (!ready) {
+                continue;
+            }
+
+            if (best == n
+                    || rate[i] * cost[best] > rate[best] * cost[i]
+                    || (rate[i] * cost[best] == rate[best] * cost[i]
+                        && cost[i] < cost[best])) {
+                best = i;
+            }
+        }
+
+        placed[best] = true;
+        optimized.rules.push_back(sorted[best]);
+    }
+
+    std::stable_sort(order, order + 3,
+        [&profile](unsigned int a, unsigned int b) {
+            return profile.getCheckRejectRate(a)
+                   > profile.getCheckRejectRate(b);
+        });
+    optimized.build(order);
+
+    return optimized;
+}
+
+bool RuleSet::reaches(unsigned int channel, uchar value) const
+{
+    return (this->reachable[channel][value >> 6] >> (value & 63)) & 1;
+}
+
+void RuleSet::build(const unsigned int *order)
+{
+    static const unsigned int channels[3] = {0, 1, 2};
+    bool full[3] = {false, false, false};
+
+    if (order == NULL) {
+        order = channels;
+    }
+
+    for (unsigned int c = 0; c < 3; c++) {
+        std::fill(this->reachable[c], this->reachable[c] + 4, 0);
+    }
+
+    for (size_t i = 0; i < this->rules.size(); i++) {
+        if (this->rules[i].accept == this->fallback) {
+            continue;
+        }
+
+        for (unsigned int c = 0; c < 3; c++) {
+            for (unsigned int w = 0; w < 4; w++) {
+                this->reachable[c][w] |= this->rules[i].bits[c][w];
+            }
+        }
+    }
+
+    /* a test that passes every value is not worth doing */
+    for (unsigned int c = 0; c < 3; c++) {
+        full[c] = true;
+        for (unsigned int w = 0; w < 4; w++) {
+            full[c] = full[c] && this->reachable[c][w] == ~(uint64_t)0;
+        }
+    }
+
+    this->num_checks = 0;
+    for (unsigned int k = 0; k < 3; k++) {
+        if (!full[order[k]]) {
+            this->checks[this->num_checks++] = order[k];
+        }
+    }
+}
+
+RuleProfile::RuleProfile(const RuleSet &rules)
+    : rules(rules),
+      samples(0),
+      passed(0),
+      tests(0),
+      matches(rules.size(), 0),
+      rejects(3 * rules.size(), 0)
+{
+    std::fill(this->check_rejects, this->check_rejects + 3, 0);
+}
+
+void RuleProfile::sample(const cv::Vec3b &value)
+{
+    bool pass = true;
+
+    this->samples++;
+    this->tests += this->rules.countTests(value);
+
+    for (unsigned int c = 0; c < 3; c++) {
+        if (!this->rules.reaches(c, value[c])) {
+            this->check_rejects[c]++;
+            pass = false;
+        }
+    }
+
+    if (!pass) {
+        return;
+    }
+
+    /* every test is evaluated to get rates independent on the order */
+    this->passed++;
+    for (size_t i = 0; i < this->rules.size(); i++) {
+        const ColorRule &rule = this->rules[i];
+        bool matched = true;
+
+        for (unsigned int c = 0; c < 3; c++) {
+            if (!rule.allows(c, value[c])) {
+                this->rejects[3 * i + c]++;
+                matched = false;
+            }
+        }
+
+        for (size_t k = 0; k < rule.getComparisons().size(); k++) {
+            if (value[rule.getComparisons()[k].first]
+                    <= value[rule.getComparisons()[k].second]) {
+                matched = false;
+            }
+        }
+
+        if (matched) {
+            this->matches[i]++;
+        }
+    }
+}
+
+void RuleProfile::sample(const cv::Mat &image,
+                         const cv::Mat &mask /*= cv::Mat()*/,
+                         unsigned int step /*= 1*/)
+{
+    const cv::Vec3b *iptr = NULL;
+    const uchar *mptr = NULL;
+    uint64_t index = 0;
+
+    if (image.type() != CV_8UC3) {
+        throw std::logic_error("Rule profile needs CV_8UC3 image!");
+    }
+
+    step = std::max(step, 1u);
+    for (int i = 0; i < image.rows; i++) {
+        iptr = image.ptr<cv::Vec3b>(i);
+        mptr = mask.empty() ? NULL : mask.ptr<uchar>(i);
+
+        for (int j = 0; j < image.cols; j++, index++) {
+            if (index % step != 0 || (mptr != NULL && mptr[j] == 0)) {
+                continue;
+            }
+
+            this->sample(iptr[j]);
+        }
+    }
+}
+
+RuleProfile & RuleProfile::operator+=(const RuleProfile &other)
+{
+    if (other.matches.size() != this->matches.size()) {
+        throw std::logic_error("Profiles belong to different rule sets!");
+    }
+
+    this->samples += other.samples;
+    this->passed += other.passed;
+    this->tests += other.tests;
+
+    for (unsigned int c = 0; c < 3; c++) {
+        this->check_rejects[c] += other.check_rejects[c];
+    }
+
+    for (size_t i = 0; i < this->matches.size(); i++) {
+        this->matches[i] += other.matches[i];
+    }
+
+    for (size_t i = 0; i < this->rejects.size(); i++) {
+        this->rejects[i] += other.rejects[i];
+    }
+
+    return *this;
+}
+
+uint64_t RuleProfile::getSamples() const
+{
+    return this->samples;
+}
+
+double RuleProfile::getTestsPerPixel() const
+{
+    return this->samples == 0 ? 0.0 : (double)this->tests / this->samples;
+}
+
+double RuleProfile::getCheckRejectRate(unsigned int channel) const
+{
+    check_channel(channel);
+
+    return this->samples == 0 ? 0.0
+           : (double)this->check_rejects[channel] / this->samples;
+}
+
+double RuleProfile::getMatchRate(size_t rule) const
+{
+    return this->passed == 0 ? 0.0
+           : (double)this->matches[rule] / this->passed;
+}
+
+double RuleProfile::getRejectRate(size_t rule, unsigned int channel) const
+{
+    check_channel(channel);
+
+    return this->passed == 0 ? 0.0
+           : (double)this->rejects[3 * rule + channel] / this->passed;
+}
+
+AdaptiveRuleSet::AdaptiveRuleSet(const RuleSet &rules,
+                                 uint64_t samples /*= 100000*/,
+                                 unsigned int step /*= 16*/)
+    : original(rules),
+      current(rules),
+      profile(rules),
+      limit(samples),
+      step(std::max(step, 1u)),
+      counter(0),
+      learning(samples > 0)
+{
+    /* noop */
+}
+
+bool AdaptiveRuleSet::isLearning() const
+{
+    return this->learning;
+}
+
+const RuleSet & AdaptiveRuleSet::getRules() const
+{
+    return this->current;
+}
+
+const RuleProfile & AdaptiveRuleSet::getProfile() const
+{
+    return this->profile;
+}
+
+void AdaptiveRuleSet::learn(const cv::Vec3b &value)
+{
+    this->profile.sample(value);
+
+    if (this->profile.getSamples() >= this->limit) {
+        this->current = this->original.optimize(this->profile);
+        this->learning = false;
+    }
+}
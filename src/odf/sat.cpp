@@ -21,7 +21,11 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <algorithm>
 #include <odf/sat.h>
+#include <odf/trace.h>
+#include <odf/metrics.h>
+#include <odf/private/kernels.h>
 
 using namespace ODF;
 
@@ -32,14 +36,27 @@ SAT::SAT()
     /* noop */
 }
 
-SAT::SAT(const cv::Mat &mask) throw (std::logic_error)
+SAT::SAT(const cv::Mat &mask)
     : have_sat(true)
 {
     if (mask.type() != CV_8U) {
         throw std::logic_error("Mask is not of CV_8U type");
     }
 
-    cv::integral(mask / 255, this->sat);
+    ODF_TRACE("sat");
+
+    const Kernels &kernels = getKernels();
+
+    /* same as cv::integral(mask / 255) without the temporary mask */
+    this->sat.create(mask.rows + 1, mask.cols + 1, CV_32S);
+    this->sat.row(0).setTo(0);
+    for (int y = 0; y < mask.rows; y++) {
+        kernels.integralRow(mask.ptr<uchar>(y), this->sat.ptr<int>(y),
+                            this->sat.ptr<int>(y + 1), mask.cols);
+    }
+
+    Metrics::add(Metrics::BytesAllocated,
+                 this->sat.total() * this->sat.elemSize());
 }
 
 double SAT::fillRatio(const cv::Rect &rect) const
@@ -64,3 +81,16 @@ double SAT::fillRatio(const cv::Rect &rect, unsigned int area) const
 
     return sum * 100.0 / area;
 }
+
+void SAT::fillRatios(int top, int bottom, int x, int width, int step,
+                     int count, unsigned int area, double *ratios) const
+{
+    if (!this->have_sat) {
+        std::fill(ratios, ratios + count, 0.0);
+        return;
+    }
+
+    getKernels().windowRatios(this->sat.ptr<int>(top),
+                              this->sat.ptr<int>(bottom),
+                              x, width, step, count, area, ratios);
+}
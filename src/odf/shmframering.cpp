@@ -0,0 +1,476 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <thread>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#include <odf/shmframering.h>
+
+#define ODF_SHMRING_MAGIC "ODFRING"
+#define ODF_SHMRING_VERSION 2
+#define ODF_SHMRING_ALIGN 4096
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "ShmFrameRing requires lock-free 64-bit atomics"
+#endif
+
+using namespace ODF;
+
+struct ShmFrameRing::Header
+{
+    std::atomic<uint64_t> magic;      /* written last, see ring_magic() */
+    uint32_t version;
+    uint32_t capacity;
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+    int32_t reserved;
+    uint64_t step;
+    uint64_t slot_size;
+    uint64_t slots_offset;
+    uint64_t data_offset;
+
+    /* separate cache lines, written by different processes */
+    char pad0[64];
+    std::atomic<uint64_t> head;       /* number of published frames */
+    char pad1[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> claimed;    /* next frame to claim */
+    char pad2[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint32_t> closed;
+    std::atomic<uint32_t> wakeup;     /* futex, bumped on commit and close */
+    std::atomic<uint32_t> sleepers;   /* consumers waiting on 'wakeup' */
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "futex word must be a plain 32-bit integer");
+
+/* Sequence lock: 2n+1 while frame n is being written, 2n+2 once it is
+ * complete. */
+struct ShmFrameRing::Slot
+{
+    std::atomic<uint64_t> sequence;
+    char name[ODF_SHMRING_NAME_SIZE];
+};
+
+/* ODF_SHMRING_MAGIC as one word, so it can be published atomically */
+static uint64_t ring_magic()
+{
+    uint64_t magic;
+
+    memcpy(&magic, ODF_SHMRING_MAGIC, sizeof(magic));
+    return magic;
+}
+
+static uint64_t align(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+ShmFrameRing::ShmFrameRing(const std::string &name,
+                           unsigned int capacity,
+                           int rows, int cols, int type,
+                           bool replace /*= false*/)
+    : name(name),
+      owner(true),
+      map(NULL),
+      map_size(0),
+      header(NULL),
+      writing(0)
+{
+    uint64_t step = align((uint64_t)cols * CV_ELEM_SIZE(type), 64);
+    uint64_t slot_size = align(step * rows, ODF_SHMRING_ALIGN);
+    uint64_t slots_offset = align(sizeof(Header), 64);
+    uint64_t data_offset = align(slots_offset + capacity * sizeof(Slot),
+                                 ODF_SHMRING_ALIGN);
+    void *ptr;
+    int fd;
+
+    if (capacity == 0) {
+        throw std::logic_error("Ring capacity must not be zero");
+    }
+
+    this->map_size = data_offset + capacity * slot_size;
+
+    if (replace) {
+        shm_unlink(name.c_str());
+    }
+
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) {
+        throw std::runtime_error("Unable to create shared memory " + name
+                                 + ": " + strerror(errno));
+    }
+
+    if (ftruncate(fd, this->map_size) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Unable to resize shared memory " + name
+                                 + ": " + strerror(errno));
+    }
+
+    ptr = mmap(NULL, this->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+               fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Unable to map shared memory " + name
+                                 + ": " + strerror(errno));
+    }
+
+    this->map = (uchar*)ptr;
+    this->header = new (ptr) Header();
+
+    this->header->version = ODF_SHMRING_VERSION;
+    this->header->capacity = capacity;
+    this->header->rows = rows;
+    this->header->cols = cols;
+    this->header->type = type;
+    this->header->step = step;
+    this->header->slot_size = slot_size;
+    this->header->slots_offset = slots_offset;
+    this->header->data_offset = data_offset;
+    this->header->head = 0;
+    this->header->claimed = 0;
+    this->header->closed = 0;
+    this->header->wakeup = 0;
+    this->header->sleepers = 0;
+
+    for (unsigned int i = 0; i < capacity; i++) {
+        new (this->slot(i)) Slot();
+        this->slot(i)->sequence = 0;
+    }
+
+    /* consumers that attach meanwhile must not see a partial header */
+    this->header->magic.store(ring_magic(), std::memory_order_release);
+}
+
+ShmFrameRing::ShmFrameRing(const std::string &name)
+    : name(name),
+      owner(false),
+      map(NULL),
+      map_size(0),
+      header(NULL),
+      writing(0)
+{
+    struct stat st;
+    void *ptr;
+    int fd;
+
+    fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1) {
+        throw std::runtime_error("Unable to open shared memory " + name
+                                 + ": " + strerror(errno));
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid frame ring " + name);
+    }
+
+    /* consumers may paint into the frames too */
+    ptr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        throw std::runtime_error("Unable to map shared memory " + name
+                                 + ": " + strerror(errno));
+    }
+
+    this->map = (uchar*)ptr;
+    this->map_size = st.st_size;
+    this->header = (Header*)ptr;
+
+    if (!ShmFrameRing::isValid(this->header, this->map_size)) {
+        munmap(this->map, this->map_size);
+        throw std::runtime_error("Invalid frame ring " + name);
+    }
+}
+
+bool ShmFrameRing::isValid(const Header *header, size_t size)
+{
+    uint64_t elem_size;
+
+    /* the producer writes the magic last, everything else is set then */
+    if (header->magic.load(std::memory_order_acquire) != ring_magic()
+            || header->version != ODF_SHMRING_VERSION) {
+        return false;
+    }
+
+    /* slot and frame areas must lie in the mapping, one after another */
+    if (header->capacity == 0
+            || header->slots_offset < sizeof(Header)
+            || header->slots_offset > header->data_offset
+            || header->data_offset > size
+            || header->capacity > (header->data_offset - header->slots_offset)
+                                  / sizeof(Slot)
+            || header->slot_size == 0
+            || header->capacity > (size - header->data_offset)
+                                  / header->slot_size) {
+        return false;
+    }
+
+    /* each frame must fit its slot */
+    if (header->rows <= 0 || header->cols <= 0
+            || (header->type & ~CV_MAT_TYPE_MASK) != 0
+            || CV_MAT_DEPTH(header->type) > CV_64F) {
+        return false;
+    }
+
+    elem_size = CV_ELEM_SIZE(header->type);
+    return header->step >= (uint64_t)header->cols * elem_size
+           && header->step <= header->slot_size / header->rows;
+}
+
+ShmFrameRing::~ShmFrameRing()
+{
+    munmap(this->map, this->map_size);
+
+    if (this->owner) {
+        shm_unlink(this->name.c_str());
+    }
+}
+
+Image ShmFrameRing::beginWrite(const std::string &filename)
+{
+    Slot *s;
+
+    if (!this->owner) {
+        throw std::logic_error("Only producer can write into the ring");
+    }
+
+    this->writing = this->header->head.load(std::memory_order_relaxed);
+    s = this->slot(this->writing);
+
+    /* mark slot as being written, consumers will reject it */
+    s->sequence.store(2 * this->writing + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memset(s->name, 0, ODF_SHMRING_NAME_SIZE);
+    filename.copy(s->name, ODF_SHMRING_NAME_SIZE - 1);
+
+    return Image(filename, this->header->rows, this->header->cols,
+                 this->header->type, this->slotData(this->writing),
+                 this->header->step);
+}
+
+void ShmFrameRing::commit()
+{
+    Slot *s = this->slot(this->writing);
+
+    if (s->sequence.load(std::memory_order_relaxed) != 2 * this->writing + 1) {
+        throw std::logic_error("No frame is being written");
+    }
+
+    s->sequence.store(2 * this->writing + 2, std::memory_order_release);
+    this->header->head.store(this->writing + 1, std::memory_order_release);
+    this->wake();
+}
+
+void ShmFrameRing::write(const std::string &filename, const cv::Mat &frame)
+{
+    if (frame.rows != this->header->rows || frame.cols != this->header->cols
+            || frame.type() != this->header->type) {
+        throw std::logic_error("Frame does not match ring dimensions");
+    }
+
+    Image image = this->beginWrite(filename);
+    cv::Mat dst = image.getImage();
+
+    frame.copyTo(dst);
+    this->commit();
+}
+
+void ShmFrameRing::close()
+{
+    this->header->closed.store(1, std::memory_order_release);
+    this->wake();
+}
+
+void ShmFrameRing::wait(uint64_t index) const
+{
+    uint32_t wakeup = this->header->wakeup.load(std::memory_order_acquire);
+
+    this->header->sleepers.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    /* the futex returns at once if a frame came since 'wakeup' was read */
+    if (this->published() <= index && !this->isClosed()) {
+#ifdef __linux__
+        syscall(SYS_futex, &this->header->wakeup, FUTEX_WAIT, wakeup,
+                NULL, NULL, 0);
+#else
+        (void)wakeup;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+    }
+
+    this->header->sleepers.fetch_sub(1);
+}
+
+void ShmFrameRing::wake()
+{
+    this->header->wakeup.fetch_add(1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    /* no system call per frame unless a consumer is idle */
+#ifdef __linux__
+    if (this->header->sleepers.load(std::memory_order_relaxed) != 0) {
+        syscall(SYS_futex, &this->header->wakeup, FUTEX_WAKE, INT_MAX,
+                NULL, NULL, 0);
+    }
+#endif
+}
+
+bool ShmFrameRing::isClosed() const
+{
+    return this->header->closed.load(std::memory_order_acquire) != 0;
+}
+
+uint64_t ShmFrameRing::published() const
+{
+    return this->header->head.load(std::memory_order_acquire);
+}
+
+unsigned int ShmFrameRing::capacity() const
+{
+    return this->header->capacity;
+}
+
+uint64_t ShmFrameRing::claim()
+{
+    return this->header->claimed.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ShmFrameRing::read(uint64_t index, std::unique_ptr<Image> &image) const
+{
+    Slot *s = this->slot(index);
+    std::string filename;
+
+    if (s->sequence.load(std::memory_order_acquire) != 2 * index + 2) {
+        return false;
+    }
+
+    filename.assign(s->name, strnlen(s->name, ODF_SHMRING_NAME_SIZE));
+
+    /* the name may have been overwritten while we copied it */
+    if (!this->isValid(index)) {
+        return false;
+    }
+
+    image.reset(new Image(filename, this->header->rows, this->header->cols,
+                          this->header->type, this->slotData(index),
+                          this->header->step));
+
+    return true;
+}
+
+bool ShmFrameRing::isValid(uint64_t index) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return this->slot(index)->sequence.load(std::memory_order_relaxed)
+           == 2 * index + 2;
+}
+
+ShmFrameRing::Slot *ShmFrameRing::slot(uint64_t index) const
+{
+    return (Slot*)(this->map + this->header->slots_offset)
+           + index % this->header->capacity;
+}
+
+uchar *ShmFrameRing::slotData(uint64_t index) const
+{
+    return this->map + this->header->data_offset
+           + (index % this->header->capacity) * this->header->slot_size;
+}
+
+ShmFrameRingSource::ShmFrameRingSource(ShmFrameRing &ring, bool shared)
+    : ring(&ring),
+      shared(shared),
+      index(0),
+      current()
+{
+    /* noop */
+}
+
+Image *ShmFrameRingSource::next()
+{
+    unsigned int attempt = 0;
+    uint64_t head;
+    uint64_t oldest;
+
+    if (this->shared) {
+        this->index = this->ring->claim();
+    } else if (this->current) {
+        this->index++;
+    }
+
+    while (true) {
+        head = this->ring->published();
+
+        if (this->index < head) {
+            /* skip frames that were already overwritten */
+            oldest = head > this->ring->capacity()
+                     ? head - this->ring->capacity() : 0;
+            if (this->index < oldest) {
+                this->index = this->shared ? this->ring->claim() : oldest;
+                continue;
+            }
+
+            if (this->ring->read(this->index, this->current)) {
+                return this->current.get();
+            }
+
+            /* overwritten meanwhile */
+            this->index = this->shared ? this->ring->claim() : this->index + 1;
+            continue;
+        }
+
+        if (this->ring->isClosed() && this->index >= this->ring->published()) {
+            this->current.reset();
+            return NULL;
+        }
+
+        /* wait for the producer, sleep only when idle for a while */
+        if (attempt < 64) {
+            std::this_thread::yield();
+            attempt++;
+        } else {
+            this->ring->wait(this->index);
+        }
+    }
+}
+
+bool ShmFrameRingSource::isCurrentValid() const
+{
+    return this->current && this->ring->isValid(this->index);
+}
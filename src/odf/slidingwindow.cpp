@@ -21,9 +21,12 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <vector>
 #include <odf/slidingwindow.h>
 #include <odf/boundingbox.h>
 #include <odf/sat.h>
+#include <odf/trace.h>
+#include <odf/metrics.h>
 
 using namespace ODF;
 
@@ -60,14 +63,47 @@ BoundingBoxVector SlidingWindow::run(const cv::Mat &mask,
 BoundingBoxVector SlidingWindow::run(const cv::Mat &mask,
                                      double threshold,
                                      const cv::Rect &tile) const
+{
+    return this->_run(mask, threshold, tile, NULL);
+}
+
+BoundingBoxVector SlidingWindow::run(const cv::Mat &mask,
+                                     double threshold,
+                                     const RegionOfInterest &roi) const
+{
+    return this->_run(mask, threshold, roi.getBoundingRect(), &roi);
+}
+
+BoundingBoxVector SlidingWindow::_run(const cv::Mat &mask,
+                                      double threshold,
+                                      cv::Rect tile,
+                                      const RegionOfInterest *roi) const
 {
     BoundingBoxVector bb;
-    SAT sat(mask);
     cv::Point tl, br; /* window coordinates */
     cv::Rect window;
+    double fill_ratio;
+    int unclipped = 0;
+    uint64_t evaluated = 0;
+    uint64_t accepted = 0;
+
+    ODF_TRACE("scan");
+
+    tile &= cv::Rect(0, 0, mask.cols, mask.rows);
+    if (tile.area() == 0) {
+        return bb;
+    }
+
+    /* summed area table of the tile only */
+    SAT sat(mask(tile));
     int height = tile.y + tile.height;
     int width = tile.x + tile.width;
-    double fill_ratio;
+
+    /* windows not clipped by the right edge are computed a row at once */
+    if (this->step_x != 0 && tile.width > (int)this->width) {
+        unclipped = (tile.width - this->width - 1) / this->step_x + 1;
+    }
+    std::vector<double> ratios(unclipped);
 
     for (tl.y = tile.y; tl.y < height; tl.y += this->step_y) {
         /* move and check bottom right y */
@@ -79,7 +115,11 @@ BoundingBoxVector SlidingWindow::run(const cv::Mat &mask,
             }
         }
 
-        for (tl.x = tile.x; tl.x < width; tl.x += this->step_x) {
+        sat.fillRatios(tl.y - tile.y, br.y - tile.y, 0, this->width,
+                       this->step_x, unclipped, this->area, ratios.data());
+
+        int k = 0;
+        for (tl.x = tile.x; tl.x < width; tl.x += this->step_x, k++) {
             /* move and check bottom right x */
             br.x = tl.x + this->width;
             if (br.x >= width) {
@@ -90,12 +130,23 @@ BoundingBoxVector SlidingWindow::run(const cv::Mat &mask,
             }
 
             window = cv::Rect(tl, br);
-            fill_ratio = sat.fillRatio(window, this->area);
+            if (roi != NULL && !roi->intersects(window)) {
+                continue;
+            }
+
+            fill_ratio = k < unclipped
+                         ? ratios[k]
+                         : sat.fillRatio(window - tile.tl(), this->area);
+            evaluated++;
             if (fill_ratio > threshold) {
                 bb.push(window, fill_ratio);
+                accepted++;
             }
         }
     }
 
+    Metrics::add(Metrics::WindowsEvaluated, evaluated);
+    Metrics::add(Metrics::WindowsAccepted, accepted);
+
     return bb;
 }
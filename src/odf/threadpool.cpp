@@ -0,0 +1,141 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <odf/threadpool.h>
+
+using namespace ODF;
+
+ThreadPool::ThreadPool(unsigned int num_threads)
+    : threads(),
+      tasks(),
+      error(),
+      pending(0),
+      stopping(false)
+{
+    if (num_threads == 0) {
+        num_threads = ThreadPool::defaultSize();
+    }
+
+    for (unsigned int i = 0; i < num_threads; i++) {
+        this->threads.push_back(std::thread(&ThreadPool::worker, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    std::vector<std::thread>::iterator it;
+
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        this->tasks_done.wait(lock, [this]() { return this->pending == 0; });
+        this->stopping = true;
+    }
+
+    this->task_available.notify_all();
+
+    for (it = this->threads.begin(); it != this->threads.end(); it++) {
+        it->join();
+    }
+}
+
+void ThreadPool::submit(const Task &task)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        this->tasks.push(task);
+        this->pending++;
+    }
+
+    this->task_available.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    std::exception_ptr ex;
+
+    this->tasks_done.wait(lock, [this]() { return this->pending == 0; });
+
+    ex = this->error;
+    this->error = std::exception_ptr();
+    if (ex) {
+        std::rethrow_exception(ex);
+    }
+}
+
+unsigned int ThreadPool::size() const
+{
+    return this->threads.size();
+}
+
+unsigned int ThreadPool::defaultSize()
+{
+    unsigned int cores = std::thread::hardware_concurrency();
+
+    return cores == 0 ? 1 : cores;
+}
+
+void ThreadPool::worker()
+{
+    Task task;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+
+            this->task_available.wait(lock, [this]() {
+                return this->stopping || !this->tasks.empty();
+            });
+
+            if (this->tasks.empty()) {
+                /* stopping and nothing left to do */
+                return;
+            }
+
+            task = this->tasks.front();
+            this->tasks.pop();
+        }
+
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            /* remember only the first failure */
+            if (!this->error) {
+                this->error = std::current_exception();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            this->pending--;
+            if (this->pending == 0) {
+                this->tasks_done.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,323 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <odf/trace.h>
+
+using namespace ODF;
+
+/* events per chunk and chunks per thread (~1M events per thread) */
+#define TRACE_CHUNK_SIZE  4096
+#define TRACE_MAX_CHUNKS  256
+
+namespace
+{
+    /**
+     * Fixed size block of events. Only the owning thread writes into it,
+     * readers see events below 'count'.
+     */
+    struct TraceChunk
+    {
+        Trace::Event events[TRACE_CHUNK_SIZE];
+        std::atomic<size_t> count;
+        std::atomic<TraceChunk*> next;
+
+        TraceChunk()
+            : count(0), next(NULL)
+        {
+            /* noop */
+        }
+    };
+
+    struct TraceBuffer
+    {
+        unsigned int tid;
+        TraceChunk head;
+        TraceChunk *tail;      /* touched only by the owning thread */
+        size_t chunks;         /* touched only by the owning thread */
+        std::atomic<size_t> dropped;
+
+        TraceBuffer(unsigned int tid)
+            : tid(tid), tail(&head), chunks(1), dropped(0)
+        {
+            /* noop */
+        }
+    };
+
+    struct TraceRegistry
+    {
+        std::mutex lock;
+        std::vector<TraceBuffer*> buffers;
+    };
+
+    TraceRegistry & registry()
+    {
+        /* buffers outlive their threads, the registry is never freed */
+        static TraceRegistry *reg = new TraceRegistry();
+        return *reg;
+    }
+
+    TraceBuffer * local_buffer()
+    {
+        static thread_local TraceBuffer *buffer = NULL;
+
+        if (buffer == NULL) {
+            TraceRegistry &reg = registry();
+            std::lock_guard<std::mutex> guard(reg.lock);
+
+            buffer = new TraceBuffer(reg.buffers.size() + 1);
+            reg.buffers.push_back(buffer);
+        }
+
+        return buffer;
+    }
+
+    /* copy events of all threads, tid is stored along each event */
+    void collect(std::vector<std::pair<unsigned int, Trace::Event> > &out)
+    {
+        TraceRegistry &reg = registry();
+        std::lock_guard<std::mutex> guard(reg.lock);
+
+        for (size_t i = 0; i < reg.buffers.size(); i++) {
+            const TraceChunk *chunk = &reg.buffers[i]->head;
+
+            while (chunk != NULL) {
+                size_t count = chunk->count.load(std::memory_order_acquire);
+                for (size_t j = 0; j < count; j++) {
+                    out.push_back(std::make_pair(reg.buffers[i]->tid,
+                                                 chunk->events[j]));
+                }
+                chunk = chunk->next.load(std::memory_order_acquire);
+            }
+        }
+    }
+
+    void write_json_string(std::ostream &stream, const char *str)
+    {
+        stream << '"';
+        for (; *str != '\0'; str++) {
+            if (*str == '"' || *str == '\\') {
+                stream << '\\';
+            }
+            stream << *str;
+        }
+        stream << '"';
+    }
+}
+
+std::atomic<bool> Trace::enabled(false);
+
+void Trace::enable(bool enable /*= true*/)
+{
+    Trace::enabled.store(enable, std::memory_order_relaxed);
+}
+
+uint64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char *name, uint64_t start, uint64_t end)
+{
+    TraceBuffer *buffer = local_buffer();
+    TraceChunk *chunk = buffer->tail;
+    size_t count = chunk->count.load(std::memory_order_relaxed);
+
+    if (count == TRACE_CHUNK_SIZE) {
+        if (buffer->chunks == TRACE_MAX_CHUNKS) {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        chunk = new TraceChunk();
+        buffer->tail->next.store(chunk, std::memory_order_release);
+        buffer->tail = chunk;
+        buffer->chunks++;
+        count = 0;
+    }
+
+    chunk->events[count].name = name;
+    chunk->events[count].start = start;
+    chunk->events[count].end = end;
+    chunk->count.store(count + 1, std::memory_order_release);
+}
+
+size_t Trace::dropped()
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    size_t dropped = 0;
+
+    for (size_t i = 0; i < reg.buffers.size(); i++) {
+        dropped += reg.buffers[i]->dropped.load(std::memory_order_relaxed);
+    }
+
+    return dropped;
+}
+
+std::vector<Trace::Stage> Trace::summary()
+{
+    std::vector<std::pair<unsigned int, Event> > events;
+    std::map<std::string, std::vector<uint64_t> > durations;
+    std::map<std::string, std::vector<uint64_t> >::iterator it;
+    std::vector<Stage> stages;
+
+    collect(events);
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event &event = events[i].second;
+        durations[event.name].push_back(event.end - event.start);
+    }
+
+    for (it = durations.begin(); it != durations.end(); it++) {
+        std::vector<uint64_t> &values = it->second;
+        Stage stage;
+
+        std::sort(values.begin(), values.end());
+
+        stage.name = it->first;
+        stage.count = values.size();
+        stage.total = 0;
+        for (size_t i = 0; i < values.size(); i++) {
+            stage.total += values[i];
+        }
+        stage.p50 = values[(values.size() - 1) * 50 / 100];
+        stage.p99 = values[(values.size() - 1) * 99 / 100];
+        stage.max = values.back();
+
+        stages.push_back(stage);
+    }
+
+    return stages;
+}
+
+void Trace::writeSummary(std::ostream &stream)
+{
+    std::vector<Stage> stages = Trace::summary();
+    std::ios::fmtflags flags = stream.flags();
+
+    stream << std::left << std::setw(12) << "stage"
+           << std::right << std::setw(10) << "count"
+           << std::setw(12) << "total ms"
+           << std::setw(12) << "p50 us"
+           << std::setw(12) << "p99 us"
+           << std::setw(12) << "max us" << std::endl;
+
+    stream << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < stages.size(); i++) {
+        stream << std::left << std::setw(12) << stages[i].name
+               << std::right << std::setw(10) << stages[i].count
+               << std::setw(12) << stages[i].total / 1e6
+               << std::setw(12) << stages[i].p50 / 1e3
+               << std::setw(12) << stages[i].p99 / 1e3
+               << std::setw(12) << stages[i].max / 1e3 << std::endl;
+    }
+
+    stream.flags(flags);
+}
+
+void Trace::exportChrome(std::ostream &stream)
+{
+    std::vector<std::pair<unsigned int, Event> > events;
+    std::vector<unsigned int> tids;
+    uint64_t base = std::numeric_limits<uint64_t>::max();
+    std::ios::fmtflags flags = stream.flags();
+
+    collect(events);
+    for (size_t i = 0; i < events.size(); i++) {
+        base = std::min(base, events[i].second.start);
+        tids.push_back(events[i].first);
+    }
+
+    std::sort(tids.begin(), tids.end());
+    tids.erase(std::unique(tids.begin(), tids.end()), tids.end());
+
+    stream << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+    for (size_t i = 0; i < tids.size(); i++) {
+        stream << (i == 0 ? "\n" : ",\n")
+               << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+               << "\"tid\": " << tids[i] << ", "
+               << "\"args\": {\"name\": \"odf-" << tids[i] << "\"}}";
+    }
+
+    /* timestamps are in microseconds */
+    stream << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event &event = events[i].second;
+
+        stream << (i == 0 && tids.empty() ? "\n" : ",\n")
+               << "{\"name\": ";
+        write_json_string(stream, event.name);
+        stream << ", \"cat\": \"odf\", \"ph\": \"X\", \"pid\": 1, "
+               << "\"tid\": " << events[i].first << ", "
+               << "\"ts\": " << (event.start - base) / 1e3 << ", "
+               << "\"dur\": " << (event.end - event.start) / 1e3 << "}";
+    }
+
+    stream << "\n]}" << std::endl;
+    stream.flags(flags);
+}
+
+bool Trace::exportChrome(const std::string &filename)
+{
+    std::ofstream file(filename.c_str());
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    Trace::exportChrome(file);
+    file.close();
+
+    return !file.fail();
+}
+
+void Trace::clear()
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+
+    for (size_t i = 0; i < reg.buffers.size(); i++) {
+        TraceBuffer *buffer = reg.buffers[i];
+        TraceChunk *chunk = buffer->head.next.load(std::memory_order_acquire);
+
+        while (chunk != NULL) {
+            TraceChunk *next = chunk->next.load(std::memory_order_acquire);
+            delete chunk;
+            chunk = next;
+        }
+
+        buffer->head.next.store(NULL, std::memory_order_release);
+        buffer->head.count.store(0, std::memory_order_release);
+        buffer->tail = &buffer->head;
+        buffer->chunks = 1;
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,592 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <cerrno>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "common/skin.h"
+#include "scenes.h"
+#include "reference.h"
+
+using namespace std;
+using namespace ODF;
+
+/* the same detection parameters as face-skin */
+#define WINDOW_HEIGHT   30
+#define WINDOW_WIDTH    30
+#define WINDOW_STEP_X   (WINDOW_WIDTH / 8)
+#define WINDOW_STEP_Y   (WINDOW_HEIGHT / 8)
+#define THRESHOLD       30
+
+/* switch the adaptive rules to the optimized order early in every scene */
+#define ADAPTIVE_SAMPLES 1000
+
+#define GOLDEN_VERSION  "odf-regression 1"
+
+#define BUDGETS_VERSION "odf-regression-budgets 1"
+
+#ifndef ODF_REGRESSION_GOLDEN_DIR
+#define ODF_REGRESSION_GOLDEN_DIR "golden"
+#endif
+
+/* time budgets depend on the host, they are kept out of the source tree */
+#ifndef ODF_REGRESSION_BUDGET_FILE
+#define ODF_REGRESSION_BUDGET_FILE "regression.budgets"
+#endif
+
+/* the name is hidden by hsv_index::SAT from odf/image.h */
+typedef class ODF::SAT SummedAreaTable;
+
+struct Config
+{
+    string golden_dir;
+    string budget_file;
+    string scene;
+    unsigned int runs;
+    double margin;     /* % over the budget that is still accepted */
+    double min_budget; /* us, budgets are never stricter than this */
+    bool record;
+    bool record_budgets;
+    bool budgets;
+    bool strict;
+
+    Config()
+        : golden_dir(ODF_REGRESSION_GOLDEN_DIR),
+          budget_file(ODF_REGRESSION_BUDGET_FILE), runs(5), margin(50),
+          min_budget(50), record(false), record_budgets(false),
+          budgets(true), strict(false)
+    {
+        /* noop */
+    }
+};
+
+/* us per stage, by scene name */
+typedef map<string, map<string, double> > Budgets;
+
+/* output of all stages on one scene */
+struct Result
+{
+    cv::Mat mask;
+    double fill;
+    BoundingBoxVector scan;
+    BoundingBoxVector merged;
+    map<string, double> times; /* us, median over runs */
+};
+
+static double elapsed_us(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, micro>(chrono::steady_clock::now()
+                                           - start).count();
+}
+
+static double median(vector<double> values)
+{
+    sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+static void run_stages(const Scene &scene,
+                       const shared_ptr<const RegionOfInterest> &roi,
+                       unsigned int runs, Result &result)
+{
+    SlidingWindow window(WINDOW_WIDTH, WINDOW_HEIGHT,
+                         WINDOW_STEP_X, WINDOW_STEP_Y);
+    map<string, vector<double> > times;
+    chrono::steady_clock::time_point start;
+    const BitsetClassifier skin(skin_rules());
+
+    for (unsigned int i = 0; i < runs; i++) {
+        Image image(scene.name + ".png", scene.image);
+        image.setRegionOfInterest(roi);
+
+        start = chrono::steady_clock::now();
+        if (scene.convert) {
+            result.mask = image.classify(skin, cv::COLOR_BGR2HSV,
+                                         scene.foreground);
+        } else {
+            result.mask = image.classify(skin, scene.foreground);
+        }
+        times["threshold"].push_back(elapsed_us(start));
+
+        start = chrono::steady_clock::now();
+        SummedAreaTable sat(result.mask);
+        result.fill = 0;
+        for (size_t j = 0; j < scene.windows.size(); j++) {
+            result.fill += sat.fillRatio(scene.windows[j]);
+        }
+        times["sat"].push_back(elapsed_us(start));
+
+        start = chrono::steady_clock::now();
+        result.scan = !roi ? window.run(result.mask, THRESHOLD)
+                           : window.run(result.mask, THRESHOLD, *roi);
+        times["scan"].push_back(elapsed_us(start));
+
+        start = chrono::steady_clock::now();
+        result.merged = BoundingBoxVector(sat, WINDOW_WIDTH * WINDOW_HEIGHT);
+        for (size_t j = 0; j < scene.windows.size(); j++) {
+            result.merged.push(scene.windows[j]);
+        }
+        times["merge"].push_back(elapsed_us(start));
+    }
+
+    for (map<string, vector<double> >::iterator it = times.begin();
+            it != times.end(); it++) {
+        result.times[it->first] = median(it->second);
+    }
+}
+
+static void describe_boxes(ostream &out, const string &name,
+                           const BoundingBoxVector &bb)
+{
+    BoundingBoxVector::const_iterator it;
+
+    out << name << " " << bb.size() << endl;
+    for (it = bb.begin(); it != bb.end(); it++) {
+        cv::Rect box = it->getBoundingBox();
+        cv::Rect fit = it->getBestFitBox();
+
+        out << "box " << box.x << " " << box.y << " " << box.width << " "
+            << box.height << " " << fit.x << " " << fit.y << " "
+            << fit.width << " " << fit.height << " " << it->getFillRatio()
+            << endl;
+    }
+}
+
+/* results in golden file format, without budgets */
+static string describe(const Result &result)
+{
+    ostringstream out;
+
+    out << fixed << setprecision(6);
+    out << GOLDEN_VERSION << endl;
+    out << "mask " << hex << ResultCache::hash(result.mask) << dec << " "
+        << cv::countNonZero(result.mask) << endl;
+    out << "fill " << result.fill << endl;
+    describe_boxes(out, "scan", result.scan);
+    describe_boxes(out, "merge", result.merged);
+
+    return out.str();
+}
+
+static bool same_boxes(const BoundingBoxVector &a, const BoundingBoxVector &b)
+{
+    BoundingBoxVector::const_iterator ia, ib;
+
+    if (a.size() != b.size()) {
+        return false;
+    }
+
+    for (ia = a.begin(), ib = b.begin(); ia != a.end(); ia++, ib++) {
+        if (ia->getBoundingBox() != ib->getBoundingBox()
+                || ia->getBestFitBox() != ib->getBestFitBox()
+                || ia->getFillRatio() != ib->getFillRatio()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * The adaptive rule set must match the rules it reorders, before and after
+ * it switches to the optimized order.
+ */
+static bool check_adaptive(const Scene &scene, string &error)
+{
+    const RuleSet rules = skin_rules();
+    AdaptiveRuleSet adaptive(rules, ADAPTIVE_SAMPLES);
+    cv::Mat image = scene.image;
+
+    if (scene.convert) {
+        cv::cvtColor(scene.image, image, cv::COLOR_BGR2HSV);
+    }
+
+    for (int y = 0; y < image.rows; y++) {
+        for (int x = 0; x < image.cols; x++) {
+            const cv::Vec3b &pixel = image.at<cv::Vec3b>(y, x);
+            if (adaptive(pixel) != rules(pixel)) {
+                error = "adaptive rule set differs from the rule set";
+                return false;
+            }
+        }
+    }
+
+    if (adaptive.isLearning()) {
+        error = "adaptive rule set was not optimized";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Compare results with the reference implementation.
+ */
+static bool check_reference(const Scene &scene, const RegionOfInterest *roi,
+                            const Result &result, string &error)
+{
+    cv::Mat mask = reference_threshold(scene, roi);
+    double fill = 0;
+
+    if (cv::countNonZero(mask != result.mask) != 0) {
+        error = "threshold mask differs from reference";
+        return false;
+    }
+
+    for (size_t i = 0; i < scene.windows.size(); i++) {
+        fill += reference_fill_ratio(mask, scene.windows[i],
+                                     scene.windows[i].area());
+    }
+
+    if (fill != result.fill) {
+        error = "fill ratios differ from reference";
+        return false;
+    }
+
+    if (!check_adaptive(scene, error)) {
+        return false;
+    }
+
+    if (!same_boxes(result.scan,
+                    reference_scan(mask, WINDOW_WIDTH, WINDOW_HEIGHT,
+                                   WINDOW_STEP_X, WINDOW_STEP_Y,
+                                   THRESHOLD, roi))) {
+        error = "sliding window boxes differ from reference";
+        return false;
+    }
+
+    return true;
+}
+
+static string golden_file(const Config &config, const Scene &scene)
+{
+    return config.golden_dir + "/" + scene.name + ".golden";
+}
+
+static bool record(const Config &config, const Scene &scene,
+                   const Result &result, string &error)
+{
+    string filename = golden_file(config, scene);
+    ofstream file;
+
+    if (mkdir(config.golden_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = "unable to create " + config.golden_dir;
+        return false;
+    }
+
+    file.open(filename.c_str());
+    file << describe(result);
+    file.close();
+
+    if (file.fail()) {
+        error = "unable to write " + filename;
+        return false;
+    }
+
+    return true;
+}
+
+enum Status { PASS, FAIL, SKIP };
+
+/**
+ * Compare results with the golden file.
+ */
+static Status check_golden(const Config &config, const Scene &scene,
+                           const Result &result, string &error)
+{
+    string filename = golden_file(config, scene);
+    ifstream file(filename.c_str());
+    istringstream actual(describe(result));
+    string expected_line;
+    string actual_line;
+    unsigned int lineno = 0;
+
+    if (!file.is_open()) {
+        error = "no golden output, run with --record";
+        return config.strict ? FAIL : SKIP;
+    }
+
+    /* outputs must match exactly */
+    while (getline(actual, actual_line)) {
+        lineno++;
+        if (!getline(file, expected_line) || expected_line != actual_line) {
+            ostringstream msg;
+            msg << filename << ":" << lineno << ": expected '"
+                << expected_line << "', got '" << actual_line << "'";
+            error = msg.str();
+            return FAIL;
+        }
+    }
+
+    if (getline(file, expected_line)) {
+        error = filename + ": unexpected line '" + expected_line + "'";
+        return FAIL;
+    }
+
+    return PASS;
+}
+
+/**
+ * Compare stage times with the budgets of this host.
+ */
+static Status check_budgets(const Config &config, const Budgets &budgets,
+                            const Scene &scene, const Result &result,
+                            string &error)
+{
+    Budgets::const_iterator scene_budgets = budgets.find(scene.name);
+    map<string, double>::const_iterator it;
+    map<string, double>::const_iterator time;
+    double budget;
+
+    if (scene_budgets == budgets.end()) {
+        /* reported, but new scenes must not break hosts with old budgets */
+        error = "no time budget, run with --record-budgets";
+        return PASS;
+    }
+
+    for (it = scene_budgets->second.begin();
+            it != scene_budgets->second.end(); it++) {
+        time = result.times.find(it->first);
+        if (time == result.times.end()) {
+            continue;
+        }
+
+        budget = max(it->second, config.min_budget)
+                 * (1 + config.margin / 100);
+        if (time->second > budget) {
+            ostringstream msg;
+            msg << fixed << setprecision(1) << "stage " << it->first
+                << " took " << time->second << " us, budget " << budget
+                << " us";
+            error = msg.str();
+            return FAIL;
+        }
+    }
+
+    return PASS;
+}
+
+/**
+ * Read budgets of all scenes from 'filename'.
+ *
+ * @return False if the file does not exist or it is malformed.
+ */
+static bool load_budgets(const string &filename, Budgets &budgets,
+                         string &error)
+{
+    ifstream file(filename.c_str());
+    string line;
+
+    if (!file.is_open()) {
+        error = "no time budgets in " + filename;
+        return false;
+    }
+
+    if (!getline(file, line) || line != BUDGETS_VERSION) {
+        error = filename + ": not a budget file";
+        return false;
+    }
+
+    while (getline(file, line)) {
+        istringstream fields(line);
+        string keyword, scene, stage;
+        double budget;
+
+        if (!(fields >> keyword >> scene >> stage >> budget)
+                || keyword != "budget") {
+            error = filename + ": unexpected line '" + line + "'";
+            return false;
+        }
+
+        budgets[scene][stage] = budget;
+    }
+
+    return true;
+}
+
+static bool save_budgets(const string &filename, const Budgets &budgets,
+                         string &error)
+{
+    Budgets::const_iterator scene;
+    map<string, double>::const_iterator it;
+    ofstream file(filename.c_str());
+
+    file << BUDGETS_VERSION << endl << fixed << setprecision(1);
+    for (scene = budgets.begin(); scene != budgets.end(); scene++) {
+        for (it = scene->second.begin(); it != scene->second.end(); it++) {
+            file << "budget " << scene->first << " " << it->first << " "
+                 << it->second << endl;
+        }
+    }
+    file.close();
+
+    if (file.fail()) {
+        error = "unable to write " + filename;
+        return false;
+    }
+
+    return true;
+}
+
+static void usage(const char *name)
+{
+    cerr << "Usage: " << name << " [--record] [--record-budgets]"
+         << " [--golden dir] [--budgets file] [--scene name] [--runs n]"
+         << " [--margin percent] [--min-budget us] [--no-budget] [--strict]"
+         << endl;
+    cerr << "Use --record to store current outputs as golden files and"
+            " timings as budgets of this host." << endl;
+    cerr << "Use --record-budgets to check outputs and store only the"
+            " timings." << endl;
+    cerr << "Use --margin to set how much a stage may exceed its budget"
+            " (default 50 %)." << endl;
+    cerr << "Use --no-budget to check or record outputs only, --strict to"
+            " fail on missing golden files." << endl;
+}
+
+static bool parse(int argc, char **argv, Config &config)
+{
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--record") {
+            config.record = true;
+        } else if (arg == "--record-budgets") {
+            config.record_budgets = true;
+        } else if (arg == "--no-budget") {
+            config.budgets = false;
+        } else if (arg == "--strict") {
+            config.strict = true;
+        } else if (arg == "--golden" && has_value) {
+            config.golden_dir = argv[++i];
+        } else if (arg == "--budgets" && has_value) {
+            config.budget_file = argv[++i];
+        } else if (arg == "--scene" && has_value) {
+            config.scene = argv[++i];
+        } else if (arg == "--runs" && has_value) {
+            config.runs = max(1, atoi(argv[++i]));
+        } else if (arg == "--margin" && has_value) {
+            config.margin = atof(argv[++i]);
+        } else if (arg == "--min-budget" && has_value) {
+            config.min_budget = atof(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    vector<Scene> scenes = create_scenes();
+    const char *labels[] = {"PASS", "FAIL", "SKIP"};
+    unsigned int failures = 0;
+    Config config;
+    Budgets budgets;
+    bool has_budgets;
+    bool save;
+    string budget_error;
+
+    if (!parse(argc, argv, config)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    save = config.budgets && (config.record || config.record_budgets);
+    has_budgets = load_budgets(config.budget_file, budgets,
+                               budget_error);
+    if (!has_budgets && config.budgets && !save) {
+        cerr << "warning: " << budget_error << ", time budgets are not checked;"
+             << " run with --record-budgets on this host" << endl;
+    }
+
+    for (size_t i = 0; i < scenes.size(); i++) {
+        const Scene &scene = scenes[i];
+        shared_ptr<const RegionOfInterest> roi;
+        Status status = PASS;
+        string error;
+        Result result;
+
+        if (!config.scene.empty() && config.scene != scene.name) {
+            continue;
+        }
+
+        if (!scene.roi.empty()) {
+            roi.reset(new RegionOfInterest(scene.roi, scene.image.size()));
+        }
+
+        try {
+            run_stages(scene, roi, config.runs, result);
+
+            if (!check_reference(scene, roi.get(), result, error)) {
+                status = FAIL;
+            } else if (config.record) {
+                status = record(config, scene, result, error) ? PASS : FAIL;
+            } else {
+                status = check_golden(config, scene, result, error);
+            }
+
+            if (status == PASS && save) {
+                budgets[scene.name] = result.times;
+            } else if (status == PASS && config.budgets && has_budgets) {
+                status = check_budgets(config, budgets, scene, result, error);
+            }
+        } catch (exception &e) {
+            status = FAIL;
+            error = e.what();
+        }
+
+        cout << labels[status] << " " << scene.name;
+        if (!error.empty()) {
+            cout << ": " << error;
+        }
+        cout << endl;
+
+        if (status == FAIL) {
+            failures++;
+        }
+    }
+
+    /* budgets of scenes that were not run are kept */
+    if (save && !save_budgets(config.budget_file, budgets,
+                                 budget_error)) {
+        cerr << budget_error << endl;
+        failures++;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
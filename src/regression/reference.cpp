@@ -0,0 +1,115 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+
+#include "common/skin.h"
+#include "reference.h"
+
+using namespace ODF;
+
+/* the hand written skin threshold checks the compiled rules the stages use */
+cv::Mat reference_threshold(const Scene &scene, const RegionOfInterest *roi)
+{
+    cv::Mat mask = cv::Mat::zeros(scene.image.rows, scene.image.cols, CV_8U);
+    cv::Mat image = scene.image;
+    bool result;
+
+    if (scene.convert) {
+        cv::cvtColor(scene.image, image, cv::COLOR_BGR2HSV);
+    }
+
+    for (int y = 0; y < image.rows; y++) {
+        for (int x = 0; x < image.cols; x++) {
+            if (roi != NULL && roi->getMask().at<uchar>(y, x) == 0) {
+                continue;
+            }
+
+            /* pixels outside of the foreground are masked to zero */
+            if (!scene.foreground.empty()
+                    && scene.foreground.at<uchar>(y, x) == 0) {
+                result = skin_threshold(cv::Vec3b(0, 0, 0));
+            } else {
+                result = skin_threshold(image.at<cv::Vec3b>(y, x));
+            }
+
+            if (result) {
+                mask.at<uchar>(y, x) = 255;
+            }
+        }
+    }
+
+    return mask;
+}
+
+double reference_fill_ratio(const cv::Mat &mask, const cv::Rect &rect,
+                            unsigned int area)
+{
+    return cv::countNonZero(mask(rect)) * 100.0 / area;
+}
+
+BoundingBoxVector reference_scan(const cv::Mat &mask,
+                                 unsigned int width,
+                                 unsigned int height,
+                                 unsigned int step_x,
+                                 unsigned int step_y,
+                                 double threshold,
+                                 const RegionOfInterest *roi)
+{
+    cv::Rect tile(0, 0, mask.cols, mask.rows);
+    BoundingBoxVector bb;
+    cv::Point tl, br;
+    cv::Rect window;
+    double fill_ratio;
+
+    if (roi != NULL) {
+        tile &= roi->getBoundingRect();
+    }
+
+    for (tl.y = tile.y; tl.y < tile.y + tile.height; tl.y += step_y) {
+        br.y = std::min<int>(tl.y + height, tile.y + tile.height - 1);
+        if (br.y <= tl.y) {
+            break;
+        }
+
+        for (tl.x = tile.x; tl.x < tile.x + tile.width; tl.x += step_x) {
+            br.x = std::min<int>(tl.x + width, tile.x + tile.width - 1);
+            if (br.x <= tl.x) {
+                break;
+            }
+
+            window = cv::Rect(tl, br);
+            if (roi != NULL && cv::countNonZero(roi->getMask()(window)) == 0) {
+                continue;
+            }
+
+            fill_ratio = reference_fill_ratio(mask, window, width * height);
+            if (fill_ratio > threshold) {
+                bb.push(window, fill_ratio);
+            }
+        }
+    }
+
+    return bb;
+}
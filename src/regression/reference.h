@@ -0,0 +1,55 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef REFERENCE_H_
+#define REFERENCE_H_
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+
+#include "scenes.h"
+
+/*
+ * Straightforward implementations of the library stages. They are slow
+ * but obviously correct and the library must give exactly the same
+ * results.
+ */
+
+/* threshold every pixel of the scene by the face-skin function */
+cv::Mat reference_threshold(const Scene &scene,
+                            const ODF::RegionOfInterest *roi);
+
+/* fill ratio of 'rect' by counting mask pixels */
+double reference_fill_ratio(const cv::Mat &mask, const cv::Rect &rect,
+                            unsigned int area);
+
+/* sliding window without summed area table */
+ODF::BoundingBoxVector reference_scan(const cv::Mat &mask,
+                                      unsigned int width,
+                                      unsigned int height,
+                                      unsigned int step_x,
+                                      unsigned int step_y,
+                                      double threshold,
+                                      const ODF::RegionOfInterest *roi);
+
+#endif /* REFERENCE_H_ */
@@ -0,0 +1,293 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/image.h>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <stdint.h>
+
+#include "scenes.h"
+
+/*
+ * Scenes are drawn without cv::RNG and the OpenCV drawing and colour
+ * conversion functions, whose output differs between OpenCV versions.
+ * Only the BGR to HSV conversion of the threshold itself is left.
+ */
+
+/* skin like colour in BGR, HSV 12 deg, 40 %, 75 % */
+static const cv::Vec3b SKIN_BGR(115, 130, 191);
+
+/* xorshift64*, the same sequence on every host */
+class Random
+{
+private:
+    uint64_t state;
+
+public:
+    Random(uint64_t seed) : state(seed) {}
+
+    uint32_t next()
+    {
+        this->state ^= this->state >> 12;
+        this->state ^= this->state << 25;
+        this->state ^= this->state >> 27;
+        return (uint32_t)((this->state * 0x2545f4914f6cdd1dULL) >> 32);
+    }
+
+    /* integer from [low, high) */
+    int uniform(int low, int high)
+    {
+        return low + (int)(this->next() % (uint32_t)(high - low));
+    }
+};
+
+static cv::Mat noise(const cv::Size &size, Random &rng)
+{
+    cv::Mat image(size, CV_8UC3);
+
+    for (int y = 0; y < image.rows; y++) {
+        uchar *row = image.ptr<uchar>(y);
+        for (int x = 0; x < image.cols * 3; x++) {
+            row[x] = (uchar)(rng.next() >> 24);
+        }
+    }
+
+    return image;
+}
+
+static uchar jitter(uchar value, int delta)
+{
+    return (uchar)std::max(0, std::min(255, value + delta));
+}
+
+/* BGR image with skin coloured ellipses on noise */
+static cv::Mat blobs(const cv::Size &size, unsigned int count, Random &rng)
+{
+    cv::Mat image = noise(size, rng);
+
+    for (unsigned int i = 0; i < count; i++) {
+        int cx = rng.uniform(0, size.width);
+        int cy = rng.uniform(0, size.height);
+        int64_t ax = rng.uniform(8, 40);
+        int64_t ay = rng.uniform(10, 50);
+        cv::Vec3b color(jitter(SKIN_BGR[0], rng.uniform(-3, 4)),
+                        jitter(SKIN_BGR[1], rng.uniform(-3, 4)),
+                        jitter(SKIN_BGR[2], rng.uniform(-3, 4)));
+
+        /* inside if (dx/ax)^2 + (dy/ay)^2 <= 1, in integers */
+        for (int y = std::max(0, cy - (int)ay);
+                y <= std::min(size.height - 1, cy + (int)ay); y++) {
+            for (int x = std::max(0, cx - (int)ax);
+                    x <= std::min(size.width - 1, cx + (int)ax); x++) {
+                int64_t dx = x - cx;
+                int64_t dy = y - cy;
+
+                if (dx * dx * ay * ay + dy * dy * ax * ax
+                        <= ax * ax * ay * ay) {
+                    image.at<cv::Vec3b>(y, x) = color;
+                }
+            }
+        }
+    }
+
+    return image;
+}
+
+/* mask covered by rectangles to roughly 'density' (0 - 1) */
+static cv::Mat density_mask(const cv::Size &size, double density,
+                            Random &rng)
+{
+    cv::Mat mask = cv::Mat::zeros(size, CV_8U);
+    cv::Rect whole(0, 0, size.width, size.height);
+    int covered = 0;
+
+    while (covered < density * size.area()) {
+        cv::Rect rect(rng.uniform(0, size.width), rng.uniform(0, size.height),
+                      rng.uniform(1, 40), rng.uniform(1, 40));
+
+        rect &= whole;
+        for (int y = rect.y; y < rect.y + rect.height; y++) {
+            for (int x = rect.x; x < rect.x + rect.width; x++) {
+                uchar &pixel = mask.at<uchar>(y, x);
+                covered += pixel == 0;
+                pixel = 255;
+            }
+        }
+    }
+
+    return mask;
+}
+
+/* HSV image where the pixels under 'mask' are skin coloured */
+static cv::Mat masked_skin(const cv::Mat &mask, Random &rng)
+{
+    cv::Mat image = noise(mask.size(), rng);
+    const cv::Vec3b skin(ODF_CONV_HUE(12), ODF_CONV_SAT(40),
+                         ODF_CONV_VAL(75));
+
+    for (int y = 0; y < image.rows; y++) {
+        for (int x = 0; x < image.cols; x++) {
+            cv::Vec3b &pixel = image.at<cv::Vec3b>(y, x);
+
+            if (mask.at<uchar>(y, x) != 0) {
+                pixel = skin;
+            } else {
+                /* background must not be skin, keep value below
+                 * saturation */
+                pixel[2] = std::min(pixel[1], pixel[2]);
+            }
+        }
+    }
+
+    return image;
+}
+
+/* windows in clusters, like a scan over several objects */
+static std::vector<cv::Rect> windows(const cv::Size &size, unsigned int count,
+                                     Random &rng)
+{
+    std::vector<cv::Rect> rects;
+    cv::Point center;
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (i % 12 == 0) {
+            center = cv::Point(rng.uniform(0, size.width - 30),
+                               rng.uniform(0, size.height - 30));
+        }
+
+        rects.push_back(cv::Rect(center.x + rng.uniform(-12, 13),
+                                 center.y + rng.uniform(-12, 13), 30, 30)
+                        & cv::Rect(0, 0, size.width, size.height));
+    }
+
+    return rects;
+}
+
+/*
+ * Pixel values around every saturation and value boundary used by the
+ * face-skin threshold, for all hues.
+ */
+static cv::Mat hsv_edges()
+{
+    const double percents[] = {0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45,
+                               50, 60, 66, 70, 85, 90, 100};
+    std::vector<int> values;
+    cv::Mat image;
+
+    for (size_t i = 0; i < sizeof(percents) / sizeof(percents[0]); i++) {
+        double value = ODF_CONV_SAT(percents[i]);
+
+        for (int d = -1; d <= 1; d++) {
+            values.push_back(std::floor(value) + d);
+            values.push_back(std::ceil(value) + d);
+        }
+    }
+
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    values.erase(std::remove_if(values.begin(), values.end(),
+                                [](int v) { return v < 0 || v > 255; }),
+                 values.end());
+
+    /* rows enumerate saturation and value, columns hue */
+    image.create(values.size() * values.size(), 180, CV_8UC3);
+    for (size_t s = 0; s < values.size(); s++) {
+        for (size_t v = 0; v < values.size(); v++) {
+            for (int h = 0; h < 180; h++) {
+                image.at<cv::Vec3b>(s * values.size() + v, h) =
+                    cv::Vec3b(h, values[s], values[v]);
+            }
+        }
+    }
+
+    return image;
+}
+
+std::vector<Scene> create_scenes()
+{
+    const cv::Size size(640, 480);
+    std::vector<Scene> scenes;
+    Random rng(0x0df);
+    cv::Mat mask;
+
+    {
+        Scene scene("blobs");
+        scene.image = blobs(size, 40, rng);
+        scene.convert = true;
+        scene.windows = windows(size, 240, rng);
+        scenes.push_back(scene);
+    }
+
+    {
+        Scene scene("blobs-foreground");
+        scene.image = blobs(size, 40, rng);
+        scene.convert = true;
+        scene.foreground = density_mask(size, 0.4, rng);
+        scene.windows = windows(size, 240, rng);
+        scenes.push_back(scene);
+    }
+
+    {
+        Scene scene("blobs-roi");
+        scene.image = blobs(size, 40, rng);
+        scene.convert = true;
+        scene.foreground = density_mask(size, 0.6, rng);
+        scene.roi.push_back(cv::Rect(37, 21, 301, 203));
+        scene.roi.push_back(cv::Rect(300, 250, 333, 222));
+        scene.windows = windows(size, 240, rng);
+        scenes.push_back(scene);
+    }
+
+    {
+        Scene scene("hsv-edges");
+        scene.image = hsv_edges();
+        scene.windows = windows(scene.image.size(), 120, rng);
+        scenes.push_back(scene);
+    }
+
+    {
+        Scene scene("dense");
+        mask = density_mask(size, 0.95, rng);
+        scene.image = masked_skin(mask, rng);
+        scene.windows = windows(size, 1200, rng);
+        scenes.push_back(scene);
+    }
+
+    {
+        Scene scene("sparse");
+        mask = density_mask(size, 0.01, rng);
+        scene.image = masked_skin(mask, rng);
+        scene.windows = windows(size, 24, rng);
+        scenes.push_back(scene);
+    }
+
+    {
+        Scene scene("empty");
+        scene.image = cv::Mat::zeros(size, CV_8UC3);
+        scenes.push_back(scene);
+    }
+
+    return scenes;
+}
@@ -0,0 +1,49 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SCENES_H_
+#define SCENES_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * Synthetic input of one regression case. All scenes are generated from
+ * fixed seeds, so they are identical on every run and host.
+ */
+struct Scene
+{
+    std::string name;
+    cv::Mat image;                 /* BGR if 'convert' is set, HSV otherwise */
+    bool convert;                  /* threshold after BGR to HSV conversion */
+    cv::Mat foreground;            /* empty if not used */
+    std::vector<cv::Rect> roi;     /* empty if the whole image is used */
+    std::vector<cv::Rect> windows; /* input of BoundingBoxVector::push */
+
+    Scene(const std::string &name) : name(name), convert(false) {}
+};
+
+std::vector<Scene> create_scenes();
+
+#endif /* SCENES_H_ */
@@ -0,0 +1,158 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <opencv2/opencv.hpp>
+#include <odf/odf.h>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+
+#include "common/options.h"
+#include "common/source.h"
+
+using namespace std;
+using namespace ODF;
+
+/**
+ * Compare running average background subtractor with MOG2 on the same
+ * frames: time spent in each of them and how much their masks agree.
+ */
+class Subtractor
+{
+public:
+    string name;
+    cv::BackgroundSubtractor *sub;
+    cv::Mat mask;
+    int64 ticks;
+
+    Subtractor(const string &name, cv::BackgroundSubtractor *sub)
+        : name(name), sub(sub), ticks(0)
+    {
+        /* noop */
+    }
+
+    ~Subtractor()
+    {
+        delete this->sub;
+    }
+
+    void run(const cv::Mat &frame)
+    {
+        int64 start = cv::getTickCount();
+
+        this->sub->operator()(frame, this->mask);
+        this->ticks += cv::getTickCount() - start;
+
+        /* MOG2 marks shadows by 127, getForegroundMask keeps them */
+        cv::threshold(this->mask, this->mask, 0, 255, cv::THRESH_BINARY);
+    }
+
+    double fps(unsigned int frames) const
+    {
+        return frames * cv::getTickFrequency() / this->ticks;
+    }
+};
+
+int main(int argc, const char **argv)
+{
+    Options opts;
+    unique_ptr<LazyImageSequence> images;
+    unique_ptr<FrameSource> source;
+    Image *image;
+    cv::Mat both;
+    cv::Mat either;
+    double pixels = 0;
+    double agree = 0;
+    double intersection = 0;
+    double union_ = 0;
+    unsigned int frames = 0;
+    int fg_both;
+    int fg_either;
+
+    if (!opts.parse(argc, argv, cerr)) {
+        Options::printUsage(cerr, argv[0]);
+        return 1;
+    }
+
+    Subtractor mog2("MOG2", new cv::BackgroundSubtractorMOG2(30, 16));
+    Subtractor average("running average",
+                       new RunningAverageBackgroundSubtractor());
+
+    try {
+        if (opts.video.length() != 0) {
+            source.reset(create_video_source(opts.video));
+        } else {
+            images.reset(new LazyImageSequence(create_sequence(opts)));
+            source.reset(new LazyImageSequenceSource(*images));
+        }
+
+        while ((image = source->next()) != NULL) {
+            if (!image->open()) {
+                cerr << "Unable to open " << image->getFilename() << endl;
+                continue;
+            }
+
+            mog2.run(image->getImage());
+            average.run(image->getImage());
+
+            /* the first frame only initializes the models */
+            if (frames++ == 0) {
+                continue;
+            }
+
+            cv::bitwise_and(mog2.mask, average.mask, both);
+            cv::bitwise_or(mog2.mask, average.mask, either);
+
+            fg_both = cv::countNonZero(both);
+            fg_either = cv::countNonZero(either);
+
+            pixels += both.total();
+            intersection += fg_both;
+            union_ += fg_either;
+            agree += both.total() - (fg_either - fg_both);
+        }
+    } catch (cv::Exception &e) {
+        cerr << "OpenCV error:" << endl << e.what() << endl;
+        return 1;
+    } catch (exception &e) {
+        cerr << "Error:" << endl << e.what() << endl;
+        return 1;
+    }
+
+    if (frames < 2) {
+        cerr << "At least two frames are needed!" << endl;
+        return 1;
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "Frames: " << frames << endl;
+    cout << mog2.name << ": " << mog2.fps(frames) << " fps" << endl;
+    cout << average.name << ": " << average.fps(frames) << " fps ("
+         << average.fps(frames) / mog2.fps(frames) << "x)" << endl;
+    cout << "Pixel agreement: " << 100.0 * agree / pixels << " %" << endl;
+    cout << "Foreground IoU: "
+         << (union_ == 0 ? 100.0 : 100.0 * intersection / union_) << " %"
+         << endl;
+
+    return 0;
+}
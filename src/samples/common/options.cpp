@@ -34,9 +34,29 @@ Options::Options()
       extension(""),
       prefix(""),
       suffix(""),
+      glob(""),
+      video(""),
+      store_in(""),
+      store_out(""),
+      output_mode("frame"),
+      model_file(""),
+      roi_file(""),
+      cache_dir(""),
+      trace_file(""),
+      metrics_file(""),
+      rules_file(""),
       num_digits(0),
       from(0),
-      to(0)
+      to(0),
+      threads(1),
+      writers(1),
+      padding(0),
+      checkpoint(0),
+      motion_threshold(0),
+      cache_size(0),
+      pipeline(false),
+      list(false),
+      refine(false)
 {
     /* no op */
 }
@@ -79,6 +99,7 @@ bool Options::parse(int argc, const char **argv, std::ostream &out)
     string current;
     bool to_set = false;
     bool from_set = false;
+    unsigned int scale = 1;
     bool bret;
 
     if (argc < 2) {
@@ -105,11 +126,64 @@ bool Options::parse(int argc, const char **argv, std::ostream &out)
             bret = this->get_arg_as_string(argc, argv, &i, &this->extension);
         } else if (current == "-o") {
             bret = this->get_arg_as_string(argc, argv, &i, &this->output_dir);
+        } else if (current == "-j") {
+            bret = this->get_arg_as_uint(argc, argv, &i, &this->threads);
+        } else if (current == "-w") {
+            bret = this->get_arg_as_uint(argc, argv, &i, &this->writers);
+        } else if (current == "-m") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->output_mode);
+        } else if (current == "-c") {
+            bret = this->get_arg_as_uint(argc, argv, &i, &this->padding);
+        } else if (current == "-g") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->glob);
+        } else if (current == "-v") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->video);
+        } else if (current == "-S") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->store_in);
+        } else if (current == "-W") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->store_out);
+        } else if (current == "-l") {
+            this->list = true;
+            bret = true;
+        } else if (current == "-P") {
+            this->pipeline = true;
+            bret = true;
         } else if (current == "-b") {
             bret = this->get_arg_as_string(argc, argv, &i, &current);
             if (bret) {
                 this->backgrounds.push_back(current);
+                this->background_scales.push_back(scale);
+            }
+        } else if (current == "-r") {
+            /* applies to following backgrounds */
+            bret = this->get_arg_as_uint(argc, argv, &i, &scale);
+            if (bret && scale == 0) {
+                out << "Background scale must be at least 1!" << endl;
+                return false;
             }
+        } else if (current == "-M") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->model_file);
+        } else if (current == "-K") {
+            bret = this->get_arg_as_uint(argc, argv, &i, &this->checkpoint);
+        } else if (current == "-I") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->roi_file);
+        } else if (current == "-C") {
+            bret = this->get_arg_as_uint(argc, argv, &i, &this->cache_size);
+        } else if (current == "-D") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->cache_dir);
+        } else if (current == "-T") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->trace_file);
+        } else if (current == "-X") {
+            bret = this->get_arg_as_string(argc, argv, &i,
+                                           &this->metrics_file);
+        } else if (current == "-F") {
+            bret = this->get_arg_as_string(argc, argv, &i, &this->rules_file);
+        } else if (current == "-G") {
+            bret = this->get_arg_as_uint(argc, argv, &i,
+                                         &this->motion_threshold);
+        } else if (current == "-R") {
+            this->refine = true;
+            bret = true;
         } else {
             if (this->input_dir.length() != 0) {
                 out << "Input directory is already set!" << endl;
@@ -126,11 +200,22 @@ bool Options::parse(int argc, const char **argv, std::ostream &out)
         }
     }
 
+    if (this->glob.length() != 0 || this->video.length() != 0
+            || this->store_in.length() != 0) {
+        /* the pattern, video or frame store selects the images */
+        return true;
+    }
+
     if (this->input_dir.length() == 0) {
         out << "Input directory is missing!" << endl;
         return false;
     }
 
+    if (this->list) {
+        /* all images in the input directory */
+        return true;
+    }
+
     if (!from_set) {
         out << "You have to specify start of the range with -f!" << endl;
         return false;
@@ -146,7 +231,6 @@ bool Options::parse(int argc, const char **argv, std::ostream &out)
 
 void Options::print(std::ostream &out) const
 {
-    std::vector<std::string>::const_iterator it;
     bool first = true;
 
     out << "Input directory: "      << this->input_dir << endl;
@@ -154,18 +238,43 @@ void Options::print(std::ostream &out) const
     out << "Allowed extension: "    << this->extension << endl;
     out << "Filename prefix: "      << this->prefix << endl;
     out << "Filename suffix: "      << this->suffix << endl;
+    out << "Filename pattern: "     << this->glob << endl;
+    out << "List directory: "       << (this->list ? "yes" : "no") << endl;
+    out << "Input video: "          << this->video << endl;
+    out << "Input frame store: "    << this->store_in << endl;
+    out << "Output frame store: "   << this->store_out << endl;
     out << "Number of digits: "     << this->num_digits << endl;
     out << "File range start: "     << this->from << endl;
     out << "File range to: "        << this->to << endl;
+    out << "Number of threads: "    << this->threads << endl;
+    out << "Output mode: "          << this->output_mode << endl;
+    out << "Crop padding: "         << this->padding << endl;
+    out << "Writer threads: "       << this->writers << endl;
+    out << "Region of interest: "   << this->roi_file << endl;
+    out << "Result cache size: "    << this->cache_size << endl;
+    out << "Result cache dir: "     << this->cache_dir << endl;
+    out << "Motion threshold: "     << this->motion_threshold << endl;
+    out << "Trace file: "           << this->trace_file << endl;
+    out << "Metrics file: "         << this->metrics_file << endl;
+    out << "Skin rules: "           << this->rules_file << endl;
+    out << "Pipeline mode: "        << (this->pipeline ? "yes" : "no") << endl;
+    out << "Background model: "     << this->model_file << endl;
+    out << "Checkpoint interval: "  << this->checkpoint << endl;
+    out << "Refine mask: "          << (this->refine ? "yes" : "no") << endl;
     out << "Background to remove: ";
 
-    for (it = this->backgrounds.begin(); it != this->backgrounds.end(); it++) {
+    for (size_t i = 0; i < this->backgrounds.size(); i++) {
         if (first) {
-            out << *it << endl;
             first = false;
         } else {
-            out << "                      " << *it << endl;
+            out << "                      ";
+        }
+
+        out << this->backgrounds[i];
+        if (this->background_scales[i] != 1) {
+            out << " (1/" << this->background_scales[i] << ")";
         }
+        out << endl;
     }
 }
 
@@ -174,7 +283,40 @@ void Options::printUsage(std::ostream &out,
 {
     out << "Usage: " << endl;
     out << program_name << " [-p prefix] [-s suffix] [-d num_digits]"
-                           " [-e extension] [-o output_dir]"
-                           " [-b background [-b ...]]"
+                           " [-e extension] [-o output_dir] [-j threads]"
+                           " [-w writers] [-m mode] [-c padding] [-P]"
+                           " [[-r scale] -b background ...] [-R]"
+                           " [-M model_file [-K frames]] [-G threshold]"
+                           " [-I roi_file] [-C entries [-D cache_dir]]"
+                           " [-T trace_file] [-X metrics_file]"
+                           " [-F rules_file]"
                            " -f from -t to input_dir" << endl;
+    out << program_name << " [options] -l input_dir" << endl;
+    out << program_name << " [options] -g pattern" << endl;
+    out << program_name << " [options] -v video_file|device" << endl;
+    out << program_name << " [options] -S frame_store" << endl;
+    out << "Use -W frame_store to decode the input into a frame store"
+           " and exit." << endl;
+    out << "Use -w 0 to save output images synchronously." << endl;
+    out << "Use -r 2 or -r 4 to model following backgrounds at 1/2 or 1/4"
+           " resolution, -R to smooth the upsampled mask." << endl;
+    out << "Use -M to restore trained background models on start and save"
+           " them on exit (the model of the N-th extra background goes to"
+           " model_file.N), -K to save them every N modelled frames"
+           " too." << endl;
+    out << "Use -G to skip frames without motion and process only changed"
+           " regions (mean block difference, e.g. 8), with -j 1 or"
+           " -P." << endl;
+    out << "Use -I to process only a region given by a mask image or a text"
+           " file with 'rect x y w h' and 'polygon x1 y1 ...' lines." << endl;
+    out << "Use -C to reuse results of identical frames, -D to keep them"
+           " on disk between runs." << endl;
+    out << "Use -T to record per-stage timings, print their summary and"
+           " save a Chrome trace (chrome://tracing, Perfetto)." << endl;
+    out << "Use -X to report work counters of each frame and dump totals"
+           " in Prometheus text format into a file every 5 seconds." << endl;
+    out << "Use -F to load skin colour rules from a file (see"
+           " face-skin/skin.rules), compiled into rules_file.cache." << endl;
+    out << "Output mode is one of frame (default), crops, best-crops,"
+           " jsonl or binary." << endl;
 }
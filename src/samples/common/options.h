@@ -35,10 +35,31 @@ public:
     std::string extension;
     std::string prefix;
     std::string suffix;
+    std::string glob;
+    std::string video;
+    std::string store_in;
+    std::string store_out;
+    std::string output_mode;
+    std::string model_file;
+    std::string roi_file;
+    std::string cache_dir;
+    std::string trace_file;
+    std::string metrics_file;
+    std::string rules_file;
     std::vector<std::string> backgrounds;
+    std::vector<unsigned int> background_scales;
     unsigned int num_digits;
     unsigned int from;
     unsigned int to;
+    unsigned int threads;
+    unsigned int writers;
+    unsigned int padding;
+    unsigned int checkpoint;
+    unsigned int motion_threshold;
+    unsigned int cache_size;
+    bool pipeline;
+    bool list;
+    bool refine;
 
     Options();
 
@@ -0,0 +1,181 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <odf/image.h>
+
+#include "common/skin.h"
+#include "common/range.h"
+#include "common/hsv.h"
+
+using namespace ODF;
+
+/**
+ * Those coefficient were selected to find skin on output from one
+ * particular foyer camera with given light conditions.
+ */
+bool skin_threshold(const cv::Vec3b &value)
+{
+    /* filter out shadow */
+    if (   in_range(value[HUE], _H(18), _H(18))
+        && in_range(value[SAT], _S(10), _S(12))) {
+        return false;
+    } else if (   in_range(value[HUE], 4, _H(0), _H(20), _H(350), _H(360))
+               && in_range(value[SAT], _S(10), _S(30))
+               && in_range(value[VAL], _V(30), _V(50))
+               && value[VAL] > value[SAT]) {
+        /* little light */
+        return true;
+    } else if (   in_range(value[HUE], _H(310), _H(340))
+               && in_range(value[SAT], _S(15), _S(30))
+               && in_range(value[VAL], _V(20), _V(35))
+               && value[VAL] > value[SAT]) {
+        /* very little light */
+        return true;
+    } else if (   in_range(value[HUE], _H(10), _H(25))
+               && in_range(value[SAT], _S(20), _S(40))
+               && in_range(value[VAL], _V(35), _V(45))
+               && value[VAL] > value[SAT]) {
+        /* little light */
+        return true;
+    } else if (   in_range(value[HUE], 4, _H(0), _H(16), _H(340), _H(360))
+               && in_range(value[SAT], _S(25), _S(40))
+               && in_range(value[VAL], _V(50), _V(70))
+               && value[VAL] > value[SAT]) {
+        /* medium light */
+        return true;
+    } else if (   in_range(value[HUE], _H(10), _H(15))
+               && in_range(value[SAT], _S(35), _S(45))
+               && in_range(value[VAL], _V(60), _V(90))
+               && value[VAL] > value[SAT]) {
+        /* high light */
+        return true;
+    } else if (   in_range(value[HUE], _H(0), _H(20))
+               && in_range(value[SAT], _S(10), _S(40))
+               && in_range(value[VAL], _V(85), _V(100))
+               && value[VAL] > value[SAT]) {
+        /* very high light */
+        return true;
+    } else if (   in_range(value[HUE], _H(310), _H(345))
+               && in_range(value[SAT], _S(20), _S(40))
+               && in_range(value[VAL], _V(35), _V(45))
+               && value[VAL] > value[SAT]) {
+        /* violet */
+        return true;
+    } else if (   in_range(value[HUE], _H(285), _H(290))
+               && in_range(value[SAT], _S(13), _S(20))
+               && in_range(value[VAL], _V(25), _V(35))
+               && value[VAL] > value[SAT]) {
+        /* violet */
+        return true;
+    } else if (   in_range(value[HUE], _H(335), _H(337))
+               && in_range(value[SAT], _S(10), _S(15))
+               && in_range(value[VAL], _V(30), _V(35))
+               && value[VAL] > value[SAT]) {
+        /* gray */
+        return true;
+    } else if (   in_range(value[HUE], _H(18), _H(25))
+               && in_range(value[SAT], _S(30), _S(45))
+               && in_range(value[VAL], _V(40), _V(66))
+               && value[VAL] > value[SAT]) {
+        /* brown */
+        return true;
+    } else if (   in_range(value[HUE], _H(290), _H(320))
+               && in_range(value[SAT], _S(0), _S(10))
+               && in_range(value[VAL], _V(90), _V(100))
+               && value[VAL] > value[SAT]) {
+        /* over-exposed but some hue left */
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Rules of skin_threshold(), the results are the same. The same rules are
+ * in face-skin/skin.rules.
+ */
+RuleSet skin_rules()
+{
+    RuleSet rules(false, cv::COLOR_BGR2HSV);
+
+    rules.add(ColorRule(false, "shadow")
+              .range(HUE, _H(18), _H(18))
+              .range(SAT, _S(10), _S(12)));
+    rules.add(ColorRule(true, "little light")
+              .range(HUE, _H(0), _H(20)).range(HUE, _H(350), _H(360))
+              .range(SAT, _S(10), _S(30))
+              .range(VAL, _V(30), _V(50))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "very little light")
+              .range(HUE, _H(310), _H(340))
+              .range(SAT, _S(15), _S(30))
+              .range(VAL, _V(20), _V(35))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "little light")
+              .range(HUE, _H(10), _H(25))
+              .range(SAT, _S(20), _S(40))
+              .range(VAL, _V(35), _V(45))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "medium light")
+              .range(HUE, _H(0), _H(16)).range(HUE, _H(340), _H(360))
+              .range(SAT, _S(25), _S(40))
+              .range(VAL, _V(50), _V(70))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "high light")
+              .range(HUE, _H(10), _H(15))
+              .range(SAT, _S(35), _S(45))
+              .range(VAL, _V(60), _V(90))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "very high light")
+              .range(HUE, _H(0), _H(20))
+              .range(SAT, _S(10), _S(40))
+              .range(VAL, _V(85), _V(100))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "violet")
+              .range(HUE, _H(310), _H(345))
+              .range(SAT, _S(20), _S(40))
+              .range(VAL, _V(35), _V(45))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "violet")
+              .range(HUE, _H(285), _H(290))
+              .range(SAT, _S(13), _S(20))
+              .range(VAL, _V(25), _V(35))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "gray")
+              .range(HUE, _H(335), _H(337))
+              .range(SAT, _S(10), _S(15))
+              .range(VAL, _V(30), _V(35))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "brown")
+              .range(HUE, _H(18), _H(25))
+              .range(SAT, _S(30), _S(45))
+              .range(VAL, _V(40), _V(66))
+              .greater(VAL, SAT));
+    rules.add(ColorRule(true, "over-exposed")
+              .range(HUE, _H(290), _H(320))
+              .range(SAT, _S(0), _S(10))
+              .range(VAL, _V(90), _V(100))
+              .greater(VAL, SAT));
+
+    return rules;
+}
@@ -0,0 +1,54 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 Pavel Březina
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdlib>
+
+#include "common/source.h"
+
+using namespace std;
+using namespace ODF;
+
+LazyImageSequence create_sequence(const Options &opts)
+{
+    if (!opts.glob.empty()) {
+        return LazyImageSequence::fromGlob(opts.glob);
+    }
+
+    if (opts.list) {
+        return LazyImageSequence::fromDirectory(opts.input_dir,
+                                                opts.extension);
+    }
+
+    return LazyImageSequence(opts.input_dir, opts.extension, opts.prefix,
+                             opts.suffix, opts.num_digits, opts.from,
+                             opts.to);
+}
+
+FrameSource *create_video_source(const string &video)
+{
+    if (video.find_first_not_of("0123456789") == string::npos) {
+        return new VideoSource(atoi(video.c_str()));
+    }
+
+    return new VideoSource(video);
+}
@@ -24,11 +24,17 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <opencv2/opencv.hpp>
 #include <odf/odf.h>
 #include <ostream>
+#include <memory>
+#include <cstdlib>
 #include <stdexcept>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <stdint.h>
 
 #include "common/options.h"
-#include "common/range.h"
-#include "common/hsv.h"
+#include "common/source.h"
+#include "common/skin.h"
 
 using namespace std;
 using namespace ODF;
@@ -39,164 +45,648 @@ using namespace ODF;
 #define WINDOW_STEP_Y   (WINDOW_HEIGHT / 8)
 #define THRESHOLD       30
 
+/* milliseconds between dumps of the metrics file */
+#define METRICS_INTERVAL 5000
+
+/**
+ * Where the results go, shared by all copies of ProcessImage.
+ */
+struct Output
+{
+    /* images are saved in background when set */
+    AsyncWriter *writer;
+
+    /* only detections are recorded when set */
+    DetectionLog *log;
+
+    /* the writer must copy the pixels */
+    bool copy;
+
+    /* background models of the reporting instance are up to date */
+    bool save_models;
+
+    /* detection results of already seen frames */
+    ResultCache *cache;
+
+    /* hash of options that affect detection, part of the cache key */
+    uint64_t params;
+
+    /* compiled skin colour rules */
+    const BitsetClassifier *skin;
+
+    Output()
+        : writer(NULL), log(NULL), copy(false), save_models(false),
+          cache(NULL), params(0), skin(NULL)
+    {
+        /* noop */
+    }
+};
+
+/**
+ * Sequence state, shared by all copies of ProcessImage. It is only used in
+ * complete(), which runs for one image at a time in sequence order.
+ */
+struct Progress
+{
+    /* number of reported frames */
+    uint64_t frame;
+
+    /* last reported objects, reused for frames without motion */
+    BoundingBoxVector last_bb;
+
+    Progress() : frame(0) {}
+};
+
 class ProcessImage
 {
 private:
     vector<cv::BackgroundSubtractor*> bg;
+    vector<PersistentBackgroundSubtractorMOG2*> models;
+    ForegroundBuffers bg_buffers;
     Options opts;
     ostream *out;
 
+    /* shared by all copies */
+    Output output;
+    shared_ptr<Progress> progress;
+
+    /* number of background model updates */
+    uint64_t updates;
+
+    /* skips frames without motion */
+    MotionGate gate;
+
+    /* result of the last processed image, reported in complete() */
+    BoundingBoxVector bb;
+    bool opened;
+    bool motion;
+    cv::Rect roi;
+    FrameStats stats;
+
+    /* static region of interest, loaded with the first image; queued
+     * images keep their own reference when it is reloaded */
+    shared_ptr<const RegionOfInterest> region;
+
 public:
-    ProcessImage(ostream &out, const Options &opts) throw (runtime_error)
-        : out(&out), opts(opts)
+    ProcessImage(ostream &out, const Options &opts,
+                 const Output &output = Output())
+        : opts(opts), out(&out), output(output),
+          progress(make_shared<Progress>()), updates(0),
+          gate(16, 4, opts.motion_threshold), opened(false), motion(true)
     {
-        cv::Mat image;
-        cv::Mat mask;
+        this->trainBackgrounds();
+    }
 
-        /* prepare background samples
-         * see OpenCV documentation on background subtractors */
-        for (unsigned int i = 0; i < this->opts.backgrounds.size(); i++) {
-            image = cv::imread(this->opts.backgrounds[i]);
-            if (image.data == NULL) {
-                throw runtime_error("Unable to read background information "
-                                    "from " + this->opts.backgrounds[i] + "!");
-            }
+    /**
+     * Each copy trains its own background subtractors, since they are
+     * updated with every processed image and can not be shared between
+     * threads.
+     */
+    ProcessImage(const ProcessImage &other)
+        : opts(other.opts), out(other.out), output(other.output),
+          progress(other.progress), updates(0),
+          gate(16, 4, other.opts.motion_threshold), opened(false),
+          motion(true)
+    {
+        this->trainBackgrounds();
+    }
 
-            this->bg.push_back(new cv::BackgroundSubtractorMOG2(30, 16));
-            this->bg[i]->operator()(image, mask);
+    ~ProcessImage()
+    {
+        vector<cv::BackgroundSubtractor*>::iterator it;
+
+        for (it = this->bg.begin(); it != this->bg.end(); it++) {
+            delete *it;
         }
     }
 
     void operator () (Image *image)
     {
+        ODF_TRACE("frame");
+
+        this->stats = FrameStats();
+        MetricsScope scope(this->stats);
+
+        this->bb = BoundingBoxVector();
+        this->opened = image->open();
+        if (!this->opened) {
+            return;
+        }
+
+        this->setRegion(image);
+        this->motion = this->checkMotion(image, this->roi);
+        if (!this->motion) {
+            return;
+        }
+
+        this->bb = this->findObjects(image, this->removeBackground(image),
+                                     this->roi);
+    }
+
+    /**
+     * Report and store results in sequence order.
+     */
+    void complete(Image *image)
+    {
+        this->report(image, this->opened, this->motion, this->roi,
+                     this->bb, this->stats);
+    }
+
+    /**
+     * Restrict processing of an opened image to the region given by -I.
+     */
+    void setRegion(Image *image)
+    {
+        const cv::Mat &matrix = image->getImage();
+
+        if (this->opts.roi_file.length() == 0) {
+            return;
+        }
+
+        image->setRegionOfInterest(
+            this->loadRegion(cv::Size(matrix.cols, matrix.rows)));
+    }
+
+    /**
+     * Decide whether the image has to be processed and which part of it.
+     * Images must be passed in sequence order.
+     */
+    bool checkMotion(Image *image, cv::Rect &roi)
+    {
+        const cv::Mat &matrix = image->getImage();
+        MotionGate::Result result;
+
+        roi = cv::Rect(0, 0, matrix.cols, matrix.rows);
+        if (this->opts.motion_threshold == 0) {
+            return true;
+        }
+
+        result = this->gate.check(matrix);
+        roi = result.roi;
+
+        return result.motion;
+    }
+
+    /**
+     * Compute foreground mask of an opened image. This updates background
+     * subtractors, so images must be passed in sequence order.
+     */
+    cv::Mat removeBackground(Image *image)
+    {
+        cv::Mat foreground;
+
+        if (this->bg.size()) {
+            image->getForegroundMask(this->bg, this->bg_buffers, foreground);
+
+            /* checkpoint in the thread that updates the models */
+            this->updates++;
+            if (this->opts.checkpoint != 0 && this->output.save_models
+                    && this->updates % this->opts.checkpoint == 0) {
+                this->saveBackgrounds();
+            }
+        }
+
+        return foreground;
+    }
+
+    /**
+     * Find faces in the region 'roi' of an opened image, reusing results
+     * of identical frames.
+     */
+    BoundingBoxVector findObjects(Image *image, const cv::Mat &foreground,
+                                  const cv::Rect &roi) const
+    {
+        const cv::Mat &matrix = image->getImage();
         BoundingBoxVector bb;
+        uint64_t content;
+
+        /* partial results depend on the previous frame */
+        if (this->output.cache == NULL
+                || roi.area() != matrix.rows * matrix.cols) {
+            return ProcessImage::detect(image, foreground, roi,
+                                        *this->output.skin);
+        }
+
+        content = ResultCache::hash(matrix);
+        if (!foreground.empty()) {
+            content = ResultCache::hash(foreground, content);
+        }
+
+        if (this->output.cache->lookup(content, this->output.params,
+                                       NULL, &bb)) {
+            return bb;
+        }
+
+        bb = ProcessImage::detect(image, foreground, roi, *this->output.skin);
+        this->output.cache->store(content, this->output.params, cv::Mat(),
+                                  bb);
+
+        return bb;
+    }
+
+    /**
+     * Find faces in the region 'roi' of an opened image.
+     */
+    static BoundingBoxVector detect(Image *image, const cv::Mat &foreground,
+                                    const cv::Rect &roi,
+                                    const BitsetClassifier &skin)
+    {
         SlidingWindow window(WINDOW_WIDTH, WINDOW_HEIGHT,
                              WINDOW_STEP_X, WINDOW_STEP_Y);
+        const RegionOfInterest *region = image->getRegionOfInterest();
+        const cv::Mat &matrix = image->getImage();
+        cv::Rect area = roi;
         cv::Mat mask;
-        cv::Mat foreground;
+        cv::Mat tile;
+
+        if (roi.area() == matrix.rows * matrix.cols) {
+            /* threshold image by skin colour, in the space of the rules */
+            mask = image->classify(skin,
+                                   skin.getConversion(),
+                                   foreground);
+
+            return region == NULL ? window.run(mask, THRESHOLD)
+                                  : window.run(mask, THRESHOLD, *region);
+        }
+
+        if (region != NULL) {
+            area &= region->getBoundingRect();
+            if (area.area() == 0) {
+                return BoundingBoxVector();
+            }
+        }
+
+        /* threshold only the changed region */
+        mask = cv::Mat::zeros(matrix.rows, matrix.cols, CV_8U);
+        tile = mask(area);
+        image->crop(area).classify(skin,
+                                   skin.getConversion(),
+                                   foreground.empty() ? foreground
+                                                      : foreground(area))
+             .copyTo(tile);
+
+        if (region != NULL) {
+            cv::bitwise_and(tile, region->getMask()(area), tile);
+        }
+
+        return window.run(mask, THRESHOLD, area);
+    }
+
+    /**
+     * Report results of an image in sequence order.
+     *
+     * @param[in] motion False if the image was skipped.
+     * @param[in] roi Region of the image that was processed.
+     * @param[in] stats Work done on the image.
+     */
+    void report(Image *image, bool opened, bool motion, const cv::Rect &roi,
+                const BoundingBoxVector &found, const FrameStats &stats)
+    {
+        BoundingBoxVector bb;
+        BoundingBoxVector::const_iterator it;
+
+        const BoundingBoxVector &last_bb = this->progress->last_bb;
+
+        if (!motion) {
+            bb = last_bb;
+        } else {
+            /* objects outside of the processed region did not move */
+            bb = found;
+            for (it = last_bb.begin(); it != last_bb.end(); it++) {
+                if ((it->getBoundingBox() & roi).area() == 0) {
+                    bb.push(*it);
+                }
+            }
+        }
+
+        if (opened) {
+            this->progress->last_bb = bb;
+        }
+
+        this->publish(image, opened, bb, stats);
+    }
+
+    void publish(Image *image, bool opened, const BoundingBoxVector &bb,
+                 const FrameStats &stats)
+    {
         ostream &out = *(this->out);
-        bool ret;
+        uint64_t frame = this->progress->frame++;
 
         out << "Processing " << image->getName() << "... ";
 
-        ret = image->open();
-        if (!ret) {
+        if (!opened) {
             cerr << "unable to open image " << endl;
             return;
         }
 
-        /* remove background */
-        if (this->bg.size()) {
-            foreground = image->getForegroundMask(this->bg);
+        out << "found " << bb.size() << " faces";
+        if (this->opts.metrics_file.length() != 0) {
+            out << " (pixels " << stats.get(Metrics::PixelsThresholded)
+                << ", masked " << stats.get(Metrics::PixelsMasked)
+                << ", windows " << stats.get(Metrics::WindowsEvaluated)
+                << ", accepted " << stats.get(Metrics::WindowsAccepted)
+                << ")";
         }
+        out << endl;
 
-        /* threshold image by skin color in HSV mode */
-        mask = image->threshold(ProcessImage::threshold,
-                                cv::COLOR_BGR2HSV,
-                                foreground);
+        if (this->output.log != NULL) {
+            this->output.log->write(frame, image->getName(), bb);
+        } else if (this->opts.output_mode == "crops"
+                   || this->opts.output_mode == "best-crops") {
+            this->saveCrops(image, bb);
+        } else {
+            /* highlight detected images in the original image */
+            image->highlightObjects(bb, Image::Red);
+            this->save(*image, this->opts.output_dir + "/%n");
+        }
 
-        /* run sliding window over the thresholded image */
-        bb = window.run(mask, THRESHOLD);
+        image->close();
+    }
 
-        /* highlight detected images in the original image */
-        out << "found " << bb.size() << " faces" << endl;
-        image->highlightObjects(bb, Image::Red);
+    /**
+     * Store trained background models into the model files. Must not run
+     * concurrently with removeBackground().
+     */
+    void saveBackgrounds() const
+    {
+        for (unsigned int i = 0; i < this->models.size(); i++) {
+            this->models[i]->saveModel(this->modelFile(i));
+        }
+    }
 
-        if (this->opts.output_dir.length() != 0) {
-            image->save(this->opts.output_dir + "/%n");
-        } else {
-            image->showAndWait("Preview");
+private:
+    /**
+     * Region given by -I for images of 'size', loaded once per size.
+     */
+    shared_ptr<const RegionOfInterest> loadRegion(const cv::Size &size)
+    {
+        if (!this->region || this->region->getSize() != size) {
+            this->region = make_shared<const RegionOfInterest>(
+                RegionOfInterest::load(this->opts.roi_file, size));
         }
 
-        image->close();
+        return this->region;
     }
 
     /**
-     * Those coefficient were selected to find skin on output from one
-     * particular foyer camera with given light conditions.
+     * Model of the first background is stored in model_file, the others
+     * in model_file.N.
      */
-    static bool threshold(const cv::Vec3b &value)
-    {
-        /* filter out shadow */
-        if (   in_range(value[HUE], _H(18), _H(18))
-            && in_range(value[SAT], _S(10), _S(12))) {
-            return false;
-        } else if (   in_range(value[HUE], 4, _H(0), _H(20), _H(350), _H(360))
-                   && in_range(value[SAT], _S(10), _S(30))
-                   && in_range(value[VAL], _V(30), _V(50))
-                   && value[VAL] > value[SAT]) {
-            /* little light */
-            return true;
-        } else if (   in_range(value[HUE], _H(310), _H(340))
-                   && in_range(value[SAT], _S(15), _S(30))
-                   && in_range(value[VAL], _V(20), _V(35))
-                   && value[VAL] > value[SAT]) {
-            /* very little light */
-            return true;
-        } else if (   in_range(value[HUE], _H(10), _H(25))
-                   && in_range(value[SAT], _S(20), _S(40))
-                   && in_range(value[VAL], _V(35), _V(45))
-                   && value[VAL] > value[SAT]) {
-            /* little light */
-            return true;
-        } else if (   in_range(value[HUE], 4, _H(0), _H(16), _H(340), _H(360))
-                   && in_range(value[SAT], _S(25), _S(40))
-                   && in_range(value[VAL], _V(50), _V(70))
-                   && value[VAL] > value[SAT]) {
-            /* medium light */
-            return true;
-        } else if (   in_range(value[HUE], _H(10), _H(15))
-                   && in_range(value[SAT], _S(35), _S(45))
-                   && in_range(value[VAL], _V(60), _V(90))
-                   && value[VAL] > value[SAT]) {
-            /* high light */
-            return true;
-        } else if (   in_range(value[HUE], _H(0), _H(20))
-                   && in_range(value[SAT], _S(10), _S(40))
-                   && in_range(value[VAL], _V(85), _V(100))
-                   && value[VAL] > value[SAT]) {
-            /* very high light */
-            return true;
-        } else if (   in_range(value[HUE], _H(310), _H(345))
-                   && in_range(value[SAT], _S(20), _S(40))
-                   && in_range(value[VAL], _V(35), _V(45))
-                   && value[VAL] > value[SAT]) {
-            /* violet */
-            return true;
-        } else if (   in_range(value[HUE], _H(285), _H(290))
-                   && in_range(value[SAT], _S(13), _S(20))
-                   && in_range(value[VAL], _V(25), _V(35))
-                   && value[VAL] > value[SAT]) {
-            /* violet */
-            return true;
-        } else if (   in_range(value[HUE], _H(335), _H(337))
-                   && in_range(value[SAT], _S(10), _S(15))
-                   && in_range(value[VAL], _V(30), _V(35))
-                   && value[VAL] > value[SAT]) {
-            /* gray */
-            return true;
-        } else if (   in_range(value[HUE], _H(18), _H(25))
-                   && in_range(value[SAT], _S(30), _S(45))
-                   && in_range(value[VAL], _V(40), _V(66))
-                   && value[VAL] > value[SAT]) {
-            /* brown */
-            return true;
-        } else if (   in_range(value[HUE], _H(290), _H(320))
-                   && in_range(value[SAT], _S(0), _S(10))
-                   && in_range(value[VAL], _V(90), _V(100))
-                   && value[VAL] > value[SAT]) {
-            /* over-exposed but some hue left */
+    string modelFile(unsigned int index) const
+    {
+        ostringstream filename;
+
+        filename << this->opts.model_file;
+        if (index != 0) {
+            filename << "." << index;
+        }
+
+        return filename.str();
+    }
+
+    void save(const Image &image, const string &filename)
+    {
+        if (this->output.writer != NULL) {
+            this->output.writer->write(image, filename, this->output.copy);
+        } else if (this->opts.output_dir.length() != 0) {
+            image.save(filename);
+        } else {
+            image.showAndWait("Preview");
+        }
+    }
+
+    /**
+     * Save each detected object into output_dir/name-N.ext.
+     */
+    void saveCrops(Image *image, const BoundingBoxVector &bb)
+    {
+        BoundingBoxVector::const_iterator it;
+        const string &name = image->getName();
+        size_t dot = name.rfind('.');
+        string base = name.substr(0, dot);
+        string ext = dot == string::npos ? ".png" : name.substr(dot);
+        bool best = this->opts.output_mode == "best-crops";
+        unsigned int i = 0;
+
+        for (it = bb.begin(); it != bb.end(); it++, i++) {
+            ostringstream filename;
+            filename << this->opts.output_dir << "/" << base << "-" << i
+                     << ext;
+
+            this->save(image->crop(best ? it->getBestFitBox()
+                                        : it->getBoundingBox(),
+                                   this->opts.padding),
+                       filename.str());
+        }
+    }
+
+    void trainBackgrounds()
+    {
+        PersistentBackgroundSubtractorMOG2 *model;
+        cv::Rect area;
+        cv::Mat image;
+        cv::Mat mask;
+
+        /* prepare background samples
+         * see OpenCV documentation on background subtractors */
+        for (unsigned int i = 0; i < this->opts.backgrounds.size(); i++) {
+            model = new PersistentBackgroundSubtractorMOG2(30, 16);
+            this->models.push_back(model);
+            this->bg.push_back(model);
+            if (this->opts.background_scales[i] != 1) {
+                this->bg[i] = new ScaledBackgroundSubtractor(this->bg[i],
+                                  this->opts.background_scales[i],
+                                  this->opts.refine);
+                this->bg_buffers.setCleaned(i);
+            }
+
+            if (this->opts.model_file.length() != 0
+                    && model->loadModel(this->modelFile(i))) {
+                continue;
+            }
+
+            image = cv::imread(this->opts.backgrounds[i]);
+            if (image.data == NULL) {
+                throw runtime_error("Unable to read background information "
+                                    "from " + this->opts.backgrounds[i] + "!");
+            }
+
+            /* the models see only the region of interest, as in
+             * Image::getForegroundMask() */
+            area = cv::Rect(0, 0, image.cols, image.rows);
+            if (this->opts.roi_file.length() != 0) {
+                area = this->loadRegion(area.size())->getBoundingRect();
+            }
+
+            if (area.area() != 0) {
+                this->bg[i]->operator()(image(area), mask);
+            }
+        }
+    }
+};
+
+/**
+ * Pipeline mode: decoding, background subtraction, detection and output run
+ * in separate threads. Background subtraction and output are ordered.
+ */
+struct Frame
+{
+    shared_ptr<Image> image;
+    bool opened;
+    bool motion;
+    cv::Rect roi;
+    cv::Mat foreground;
+    BoundingBoxVector bb;
+    FrameStats stats;
+
+    Frame() : image(), opened(false), motion(true) {}
+};
+
+class LoadStage : public PipelineStage<Frame>
+{
+public:
+    bool process(Frame &frame)
+    {
+        MetricsScope scope(frame.stats);
+        frame.opened = frame.image->open();
+        return true;
+    }
+};
+
+class ForegroundStage : public PipelineStage<Frame>
+{
+private:
+    ProcessImage *processor;
+
+public:
+    ForegroundStage(ProcessImage *processor) : processor(processor) {}
+
+    bool process(Frame &frame)
+    {
+        if (!frame.opened) {
             return true;
         }
 
-        return false;
+        MetricsScope scope(frame.stats);
+        this->processor->setRegion(frame.image.get());
+        frame.motion = this->processor->checkMotion(frame.image.get(),
+                                                    frame.roi);
+        if (frame.motion) {
+            frame.foreground = this->processor->removeBackground(frame.image.get());
+        }
+
+        return true;
+    }
+};
+
+class DetectStage : public PipelineStage<Frame>
+{
+private:
+    const ProcessImage *processor;
+
+public:
+    DetectStage(const ProcessImage *processor) : processor(processor) {}
+
+    bool process(Frame &frame)
+    {
+        if (frame.opened && frame.motion) {
+            MetricsScope scope(frame.stats);
+            frame.bb = this->processor->findObjects(frame.image.get(),
+                                                    frame.foreground,
+                                                    frame.roi);
+        }
+
+        return true;
+    }
+};
+
+class OutputStage : public PipelineStage<Frame>
+{
+private:
+    ProcessImage *processor;
+
+public:
+    OutputStage(ProcessImage *processor) : processor(processor) {}
+
+    bool process(Frame &frame)
+    {
+        this->processor->report(frame.image.get(), frame.opened, frame.motion,
+                                frame.roi, frame.bb, frame.stats);
+        return true;
     }
 };
 
+static void run_pipeline(FrameSource &source, ProcessImage &processor,
+                         const Options &opts, ostream &out)
+{
+    Pipeline<Frame> pipeline;
+    LoadStage load;
+    ForegroundStage foreground(&processor);
+    DetectStage detect(&processor);
+    OutputStage output(&processor);
+    vector<Pipeline<Frame>::Statistics> stats;
+    Image *image;
+    Frame frame;
+
+    pipeline.addStage("load", &load, opts.threads);
+    pipeline.addStage("foreground", &foreground, 1, true);
+    pipeline.addStage("detect", &detect, opts.threads);
+    pipeline.addStage("output", &output, 1, true);
+    pipeline.start();
+
+    while ((image = source.next()) != NULL) {
+        /* source may reuse the image for the next frame */
+        frame.image = make_shared<Image>(image->clone());
+        if (!pipeline.push(frame)) {
+            break;
+        }
+    }
+
+    pipeline.finish();
+
+    out << endl << "Pipeline statistics:" << endl;
+    stats = pipeline.getStatistics();
+    for (unsigned int i = 0; i < stats.size(); i++) {
+        out << "  " << stats[i].name
+            << ": threads " << stats[i].num_threads
+            << ", items " << stats[i].items
+            << ", busy " << stats[i].busy_ms << " ms"
+            << ", starved " << stats[i].starved_ms << " ms"
+            << ", blocked " << stats[i].blocked_ms << " ms" << endl;
+    }
+}
+
+/**
+ * Options that change detection results of a frame. Files are hashed by
+ * content, so editing them invalidates cached results.
+ */
+static uint64_t detection_params(const Options &opts)
+{
+    ostringstream params;
+
+    params << "face-skin 1 " << WINDOW_WIDTH << " " << WINDOW_HEIGHT << " "
+           << WINDOW_STEP_X << " " << WINDOW_STEP_Y << " " << THRESHOLD
+           << " roi="
+           << (opts.roi_file.length() == 0
+               ? 0 : ResultCache::hashFile(opts.roi_file))
+           << " rules="
+           << (opts.rules_file.length() == 0
+               ? 0 : ResultCache::hashFile(opts.rules_file));
+
+    return ResultCache::hash(params.str());
+}
+
+static void report_write_error(const string &filename, bool success,
+                               const string &error)
+{
+    if (!success) {
+        cerr << "Unable to save " << filename << ": " << error << endl;
+    }
+}
+
 int main(int argc, const char **argv)
 {
     Options opts;
-    ImageSequence images;
     bool ret;
 
     /* parse command line */
@@ -206,19 +696,159 @@ int main(int argc, const char **argv)
         return 1;
     }
 
+    if (opts.output_mode != "frame" && opts.output_mode != "crops"
+            && opts.output_mode != "best-crops" && opts.output_mode != "jsonl"
+            && opts.output_mode != "binary") {
+        cerr << "Unknown output mode " << opts.output_mode << "!" << endl;
+        return 1;
+    }
+
+    if (opts.output_mode != "frame" && opts.output_dir.length() == 0) {
+        cerr << "Output mode " << opts.output_mode
+             << " requires output directory!" << endl;
+        return 1;
+    }
+
+    /* each worker copy would compare frames that are not adjacent */
+    if (opts.motion_threshold != 0 && opts.threads != 1 && !opts.pipeline) {
+        cerr << "Motion gate requires -j 1 or pipeline mode!" << endl;
+        return 1;
+    }
+
+    if (opts.pipeline && opts.output_dir.length() == 0
+            && opts.store_out.length() == 0) {
+        cerr << "Pipeline mode requires output directory!" << endl;
+        return 1;
+    }
+
     /* print current configuration */
     opts.print(cout);
     cout << endl;
 
-    /* create sequence of images */
-    images = ImageSequence(opts.input_dir, opts.extension, opts.prefix,
-                           opts.suffix, opts.num_digits, opts.from,
-                           opts.to);
+    if (opts.trace_file.length() != 0) {
+        Trace::enable();
+    }
+
+    unique_ptr<MetricsExporter> exporter;
+    if (opts.metrics_file.length() != 0) {
+        exporter.reset(new MetricsExporter(opts.metrics_file,
+                                           METRICS_INTERVAL));
+    }
 
     /* process images */
     try {
-        ProcessImage processor(cout, opts);
-        images.run(processor);
+        unique_ptr<LazyImageSequence> images;
+        unique_ptr<FrameStore> store;
+        unique_ptr<FrameSource> source;
+
+        if (opts.store_in.length() != 0) {
+            store.reset(new FrameStore(opts.store_in));
+            source.reset(new FrameStoreSource(*store));
+        } else if (opts.video.length() != 0) {
+            source.reset(create_video_source(opts.video));
+        } else {
+            images.reset(new LazyImageSequence(create_sequence(opts)));
+            source.reset(new LazyImageSequenceSource(*images));
+        }
+
+        if (opts.store_out.length() != 0) {
+            /* only decode the input once for later runs */
+            cout << "Stored " << FrameStore::create(opts.store_out, *source)
+                 << " frames into " << opts.store_out << endl;
+            return 0;
+        }
+
+        unique_ptr<AsyncWriter> writer;
+        unique_ptr<DetectionLog> log;
+        unique_ptr<ResultCache> cache;
+        Output output;
+
+        if (opts.output_mode == "jsonl") {
+            log.reset(new DetectionLog(opts.output_dir + "/detections.jsonl",
+                                       DetectionLog::JSONL));
+        } else if (opts.output_mode == "binary") {
+            log.reset(new DetectionLog(opts.output_dir + "/detections.bin",
+                                       DetectionLog::Binary));
+        } else if (opts.output_dir.length() != 0 && opts.writers != 0) {
+            writer.reset(new AsyncWriter(opts.writers, 4 * opts.writers,
+                                         vector<int>(), report_write_error));
+        }
+
+        output.writer = writer.get();
+        output.log = log.get();
+
+        /* video frames are captured into the same buffer */
+        output.copy = !store && opts.video.length() != 0 && !opts.pipeline;
+
+        if (opts.cache_size != 0) {
+            cache.reset(new ResultCache(opts.cache_size, opts.cache_dir));
+            output.cache = cache.get();
+            output.params = detection_params(opts);
+        }
+
+        /* with parallel workers each copy learns only from a part of the
+         * sequence, the instance in this thread is not updated at all */
+        output.save_models = opts.model_file.length() != 0
+                             && (opts.threads == 1 || opts.pipeline);
+        if (opts.model_file.length() != 0 && !output.save_models) {
+            cerr << "Background models are not saved with -j > 1"
+                    " unless -P is used" << endl;
+        }
+
+        /* the same rules as -F face-skin/skin.rules by default */
+        unique_ptr<BitsetClassifier> skin;
+        if (opts.rules_file.length() != 0) {
+            skin.reset(new BitsetClassifier(BitsetClassifier::load(
+                opts.rules_file, opts.rules_file + ".cache")));
+        } else {
+            skin.reset(new BitsetClassifier(skin_rules()));
+        }
+        output.skin = skin.get();
+
+        ProcessImage processor(cout, opts, output);
+
+        if (opts.pipeline) {
+            run_pipeline(*source, processor, opts, cout);
+        } else if (store) {
+            /* frames are not copied between threads */
+            store->runOrdered(processor, opts.threads);
+        } else {
+            source->runOrdered(processor, opts.threads);
+        }
+
+        if (log) {
+            log->flush();
+        }
+
+        if (output.save_models) {
+            processor.saveBackgrounds();
+        }
+
+        if (cache) {
+            ResultCache::Statistics stats = cache->getStatistics();
+            cout << "Result cache: " << stats.hits << " hits, "
+                 << stats.disk_hits << " disk hits, " << stats.misses
+                 << " misses" << endl;
+            if (stats.write_failures != 0) {
+                cerr << stats.write_failures << " results were not saved"
+                        " into " << opts.cache_dir << endl;
+            }
+        }
+
+        if (writer) {
+            writer->flush();
+            if (writer->failures() != 0) {
+                cerr << writer->failures() << " images were not saved"
+                     << endl;
+            }
+        }
+
+        if (opts.trace_file.length() != 0) {
+            Trace::writeSummary(cout);
+            if (!Trace::exportChrome(opts.trace_file)) {
+                cerr << "Unable to write trace " << opts.trace_file << endl;
+            }
+        }
     } catch (cv::Exception &e) {
         cerr << "OpenCV error:" << endl << e.what() << endl;
     } catch (exception &e) {